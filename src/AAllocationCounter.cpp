@@ -0,0 +1,94 @@
+#include <AAllocationCounter>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+} // namespace
+
+#if defined(MYGAME_COUNT_ALLOCATIONS)
+
+namespace {
+
+void* allocate(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocateAligned(std::size_t size, std::size_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size = size ? size : 1;
+#if defined(_WIN32)
+    void* pointer = _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc wants a multiple of the alignment.
+    void* pointer = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    if (pointer) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void freeAligned(void* pointer) {
+#if defined(_WIN32)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+} // namespace
+
+// The array and nothrow forms forward to these by default.
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+bool AAllocationCounter::isEnabled() {
+    return true;
+}
+
+#else
+
+bool AAllocationCounter::isEnabled() {
+    return false;
+}
+
+#endif
+
+uint64_t AAllocationCounter::getCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
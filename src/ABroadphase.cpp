@@ -0,0 +1,293 @@
+#include <ABroadphase>
+#include <AWorkerPool>
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AB_BROADPHASE_SSE 1
+#endif
+
+namespace {
+
+// Fewer sweep entries than this per thread are swept on the calling thread alone.
+constexpr size_t kMinEntriesPerThread = 8192;
+// Strips are kept at least this full, and at least this many average box extents wide, so few
+// boxes land in more than one.
+constexpr size_t kMinEntriesPerStrip = 256;
+constexpr float kStripWidthInExtents = 4.0f;
+constexpr uint32_t kMaxStrips = 4096;
+// An insertion sort doing more moves than this per entry is abandoned for a full sort.
+constexpr size_t kMaxSwapsPerEntry = 8;
+// The sweep axis only changes once another axis spreads the centers this much more.
+constexpr float kAxisSwitchRatio = 2.0f;
+
+} // namespace
+
+void ABroadphase::clear() {
+    for (const Entry& entry : entries_) {
+        present_[entry.id] = 0;
+        sorted_[entry.id] = 0;
+    }
+    for (uint32_t id : added_) {
+        present_[id] = 0;
+    }
+    entries_.clear();
+    added_.clear();
+    itemCount_ = 0;
+}
+
+bool ABroadphase::contains(uint32_t id) const {
+    return id < present_.size() && present_[id];
+}
+
+void ABroadphase::update(uint32_t id, const glm::vec3& min, const glm::vec3& max) {
+    if (id >= present_.size()) {
+        const size_t size = std::max<size_t>(id + 1, present_.size() * 2);
+        boxMin_.resize(size, glm::vec3(0.0f));
+        boxMax_.resize(size, glm::vec3(0.0f));
+        present_.resize(size, 0);
+        sorted_.resize(size, 0);
+    }
+    boxMin_[id] = min;
+    boxMax_[id] = max;
+    if (!present_[id]) {
+        present_[id] = 1;
+        ++itemCount_;
+        // A removed id still in entries_ is simply kept there.
+        if (!sorted_[id]) {
+            added_.push_back(id);
+        }
+    }
+}
+
+void ABroadphase::remove(uint32_t id) {
+    if (!contains(id)) {
+        return;
+    }
+    present_[id] = 0;
+    --itemCount_;
+}
+
+void ABroadphase::prepare() {
+    stats_ = Stats{};
+    // Refresh boxes in sorted order and compact out removed ids; new ids go at the end.
+    size_t kept = 0;
+    for (const Entry& entry : entries_) {
+        const uint32_t id = entry.id;
+        if (!present_[id]) {
+            sorted_[id] = 0;
+            continue;
+        }
+        entries_[kept++] = Entry{boxMin_[id], boxMax_[id], id};
+    }
+    entries_.resize(kept);
+    for (uint32_t id : added_) {
+        if (present_[id] && !sorted_[id]) {
+            sorted_[id] = 1;
+            entries_.push_back(Entry{boxMin_[id], boxMax_[id], id});
+        }
+    }
+    added_.clear();
+
+    // The spread of box centers picks the sweep and strip axes; bounds and average extent size
+    // the strips. Centers are doubled and taken relative to the first box, which keeps the float
+    // variance from cancelling out far from the origin.
+    const size_t count = entries_.size();
+    float low[3];
+    float high[3];
+    float extent[3];
+    float sum[3];
+    float sumSquares[3];
+    float reference[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        low[axis] = std::numeric_limits<float>::max();
+        high[axis] = -std::numeric_limits<float>::max();
+        extent[axis] = 0.0f;
+        sum[axis] = 0.0f;
+        sumSquares[axis] = 0.0f;
+        reference[axis] = count > 0 ? entries_[0].min[axis] + entries_[0].max[axis] : 0.0f;
+    }
+    for (const Entry& entry : entries_) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const float center = entry.min[axis] + entry.max[axis] - reference[axis];
+            low[axis] = std::min(low[axis], entry.min[axis]);
+            high[axis] = std::max(high[axis], entry.max[axis]);
+            extent[axis] += entry.max[axis] - entry.min[axis];
+            sum[axis] += center;
+            sumSquares[axis] += center * center;
+        }
+    }
+    int best = axis_;
+    float variance[3] = {0.0f, 0.0f, 0.0f};
+    for (int axis = 0; axis < 3 && count > 0; ++axis) {
+        const float mean = sum[axis] / static_cast<float>(count);
+        variance[axis] = sumSquares[axis] / static_cast<float>(count) - mean * mean;
+        if (variance[axis] > variance[best]) {
+            best = axis;
+        }
+    }
+    bool fullSort = false;
+    if (best != axis_ && variance[best] > kAxisSwitchRatio * variance[axis_]) {
+        axis_ = best;
+        fullSort = true;
+    }
+    const int first = (axis_ + 1) % 3;
+    const int second = (axis_ + 2) % 3;
+    stripAxis_ = variance[second] > variance[first] ? second : first;
+
+    const int axis = axis_;
+    auto less = [axis](const Entry& a, const Entry& b) { return a.min[axis] < b.min[axis]; };
+    if (!fullSort) {
+        // Entries carried over are nearly sorted; new ones are sorted apart and merged in.
+        const size_t carried = kept;
+        const size_t budget = kMaxSwapsPerEntry * carried;
+        size_t swaps = 0;
+        for (size_t i = 1; i < carried && !fullSort; ++i) {
+            if (entries_[i - 1].min[axis] <= entries_[i].min[axis]) {
+                continue;
+            }
+            const Entry entry = entries_[i];
+            const float key = entry.min[axis];
+            size_t j = i;
+            while (j > 0 && entries_[j - 1].min[axis] > key) {
+                entries_[j] = entries_[j - 1];
+                --j;
+            }
+            entries_[j] = entry;
+            swaps += i - j;
+            fullSort = swaps > budget;
+        }
+        stats_.swaps = static_cast<uint32_t>(std::min<size_t>(swaps, 0xFFFFFFFFu));
+        if (!fullSort && carried < count) {
+            std::sort(entries_.begin() + carried, entries_.end(), less);
+            std::inplace_merge(entries_.begin(), entries_.begin() + carried, entries_.end(), less);
+        }
+    }
+    if (fullSort) {
+        std::sort(entries_.begin(), entries_.end(), less);
+    }
+    stats_.fullSort = fullSort;
+    stats_.axis = axis_;
+    buildStrips(glm::vec3(low[0], low[1], low[2]), glm::vec3(high[0], high[1], high[2]),
+                glm::vec3(extent[0], extent[1], extent[2]));
+}
+
+void ABroadphase::buildStrips(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& extentSum) {
+    const size_t count = entries_.size();
+    const int axis = stripAxis_;
+    const float span = count > 0 ? boundsMax[axis] - boundsMin[axis] : 0.0f;
+    uint32_t strips = 1;
+    if (count >= 2 * kMinEntriesPerStrip && span > 0.0f) {
+        const float averageExtent = extentSum[axis] / static_cast<float>(count);
+        const float byExtent = averageExtent > 0.0f ? span / (kStripWidthInExtents * averageExtent) : static_cast<float>(kMaxStrips);
+        const float wanted = std::min(static_cast<float>(count / kMinEntriesPerStrip), byExtent);
+        strips = static_cast<uint32_t>(std::clamp(wanted, 1.0f, static_cast<float>(kMaxStrips)));
+    }
+    stripOrigin_ = count > 0 ? boundsMin[axis] : 0.0f;
+    inverseStripWidth_ = strips > 1 ? static_cast<float>(strips) / span : 0.0f;
+    stripStart_.assign(strips + 1, 0);
+
+    // Count, turn counts into starts, then fill, advancing each start to its strip's end; a
+    // final shift restores the starts.
+    stripRanges_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t first = stripOf(entries_[i].min[axis]);
+        const uint32_t last = stripOf(entries_[i].max[axis]);
+        stripRanges_[i] = {first, last};
+        for (uint32_t strip = first; strip <= last; ++strip) {
+            ++stripStart_[strip + 1];
+        }
+    }
+    for (uint32_t strip = 1; strip <= strips; ++strip) {
+        stripStart_[strip] += stripStart_[strip - 1];
+    }
+    stripEntries_.resize(stripStart_[strips]);
+    const int sweepAxis = axis_;
+    const int thirdAxis = 3 - axis_ - axis;
+    for (size_t i = 0; i < count; ++i) {
+        const Entry& entry = entries_[i];
+        SweepEntry sweepEntry;
+        sweepEntry.lower[0] = entry.min[axis];
+        sweepEntry.lower[1] = entry.min[thirdAxis];
+        sweepEntry.lower[2] = -entry.max[axis];
+        sweepEntry.lower[3] = -entry.max[thirdAxis];
+        sweepEntry.upper[0] = entry.max[axis];
+        sweepEntry.upper[1] = entry.max[thirdAxis];
+        sweepEntry.upper[2] = -entry.min[axis];
+        sweepEntry.upper[3] = -entry.min[thirdAxis];
+        sweepEntry.begin = entry.min[sweepAxis];
+        sweepEntry.end = entry.max[sweepAxis];
+        sweepEntry.id = entry.id;
+        for (uint32_t strip = stripRanges_[i].first; strip <= stripRanges_[i].second; ++strip) {
+            stripEntries_[stripStart_[strip]++] = sweepEntry;
+        }
+    }
+    for (uint32_t strip = strips; strip > 0; --strip) {
+        stripStart_[strip] = stripStart_[strip - 1];
+    }
+    stripStart_[0] = 0;
+    stats_.stripAxis = stripAxis_;
+    stats_.stripCount = strips;
+}
+
+uint32_t ABroadphase::stripOf(float coordinate) const {
+    const float last = static_cast<float>(stripStart_.size() - 2);
+    return static_cast<uint32_t>(std::clamp((coordinate - stripOrigin_) * inverseStripWidth_, 0.0f, last));
+}
+
+void ABroadphase::sweep(size_t begin, size_t end, std::vector<Pair>& outPairs) const {
+    const bool striped = stripStart_.size() > 2;
+    for (size_t strip = begin; strip < end; ++strip) {
+        const size_t stripEnd = stripStart_[strip + 1];
+        for (size_t i = stripStart_[strip]; i < stripEnd; ++i) {
+            const SweepEntry& entry = stripEntries_[i];
+            const float limit = entry.end;
+#if AB_BROADPHASE_SSE
+            const __m128 lower = _mm_load_ps(entry.lower);
+#endif
+            // Every later entry starts at or after this one on the sweep axis, so the scan stops
+            // at the first that starts past its end.
+            for (size_t j = i + 1; j < stripEnd && stripEntries_[j].begin <= limit; ++j) {
+                const SweepEntry& other = stripEntries_[j];
+#if AB_BROADPHASE_SSE
+                const bool overlaps = _mm_movemask_ps(_mm_cmple_ps(lower, _mm_load_ps(other.upper))) == 0xF;
+#else
+                const bool overlaps = (entry.lower[0] <= other.upper[0]) & (entry.lower[1] <= other.upper[1]) &
+                                      (entry.lower[2] <= other.upper[2]) & (entry.lower[3] <= other.upper[3]);
+#endif
+                if (overlaps) {
+                    // Boxes sharing several strips pair up in each; only the strip holding the
+                    // start of their overlap reports it.
+                    if (striped && stripOf(std::max(entry.lower[0], other.lower[0])) != strip) {
+                        continue;
+                    }
+                    outPairs.push_back(Pair{std::min(entry.id, other.id), std::max(entry.id, other.id)});
+                }
+            }
+        }
+    }
+}
+
+void ABroadphase::findPairs(std::vector<Pair>& outPairs) {
+    prepare();
+    outPairs.clear();
+    sweep(0, stripStart_.size() - 1, outPairs);
+}
+
+void ABroadphase::findPairsParallel(std::vector<Pair>& outPairs) {
+    prepare();
+    const size_t strips = stripStart_.size() - 1;
+    AWorkerPool& pool = AWorkerPool::shared();
+    const size_t chunks = std::clamp<size_t>(stripEntries_.size() / kMinEntriesPerThread, 1, std::min<size_t>(pool.getThreadCount(), strips));
+    threadPairs_.resize(std::max(threadPairs_.size(), chunks));
+    pool.parallelFor(strips, chunks, [&](size_t chunk, size_t begin, size_t end) {
+        threadPairs_[chunk].clear();
+        sweep(begin, end, threadPairs_[chunk]);
+    });
+    outPairs.clear();
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        outPairs.insert(outPairs.end(), threadPairs_[chunk].begin(), threadPairs_[chunk].end());
+    }
+}
@@ -0,0 +1,425 @@
+#include <ABvh>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace {
+
+constexpr uint32_t kBinCount = 12;
+constexpr uint32_t kStackSize = 64;
+
+float surfaceArea(const glm::vec3& min, const glm::vec3& max) {
+    const glm::vec3 d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+bool isEmptyBox(const glm::vec3& min, const glm::vec3& max) {
+    return min.x > max.x;
+}
+
+bool overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB) {
+    return minA.x <= maxB.x && maxA.x >= minB.x &&
+           minA.y <= maxB.y && maxA.y >= minB.y &&
+           minA.z <= maxB.z && maxA.z >= minB.z;
+}
+
+bool overlapsSphere(const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radius) {
+    const glm::vec3 closest = glm::min(glm::max(center, min), max);
+    const glm::vec3 d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+bool hitsRay(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance) {
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (min[axis] - origin[axis]) * invDirection[axis];
+        float t1 = (max[axis] - origin[axis]) * invDirection[axis];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        tMin = std::max(tMin, t0);
+        tMax = std::min(tMax, t1);
+        if (tMin > tMax) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void ABvh::clear() {
+    for (uint32_t id : items_) {
+        leafOf_[id] = kNone;
+    }
+    nodes_.clear();
+    items_.clear();
+    itemCount_ = 0;
+}
+
+void ABvh::build(std::span<const uint32_t> ids, std::span<const glm::vec3> mins, std::span<const glm::vec3> maxs) {
+    clear();
+    if (ids.empty()) {
+        return;
+    }
+
+    const uint32_t maxId = *std::max_element(ids.begin(), ids.end());
+    if (boxMin_.size() <= maxId) {
+        boxMin_.resize(static_cast<size_t>(maxId) + 1);
+        boxMax_.resize(static_cast<size_t>(maxId) + 1);
+        leafOf_.resize(static_cast<size_t>(maxId) + 1, kNone);
+    }
+    // Partition compact copies instead of ids so the build streams memory instead of gathering it.
+    buildRefs_.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        boxMin_[ids[i]] = mins[i];
+        boxMax_[ids[i]] = maxs[i];
+        buildRefs_[i] = BuildRef{mins[i], maxs[i], (mins[i] + maxs[i]) * 0.5f, ids[i]};
+    }
+    itemCount_ = static_cast<uint32_t>(ids.size());
+
+    // Node and centroid bounds travel with each task; children get theirs from the bins of the
+    // chosen split, so every level costs one binning pass and one partition pass.
+    struct Range {
+        glm::vec3 min{std::numeric_limits<float>::max()};
+        glm::vec3 max{std::numeric_limits<float>::lowest()};
+        glm::vec3 centroidMin{std::numeric_limits<float>::max()};
+        glm::vec3 centroidMax{std::numeric_limits<float>::lowest()};
+        uint32_t count{0};
+
+        void add(const Range& other) {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+            centroidMin = glm::min(centroidMin, other.centroidMin);
+            centroidMax = glm::max(centroidMax, other.centroidMax);
+            count += other.count;
+        }
+        void add(const BuildRef& ref) {
+            min = glm::min(min, ref.min);
+            max = glm::max(max, ref.max);
+            centroidMin = glm::min(centroidMin, ref.centroid);
+            centroidMax = glm::max(centroidMax, ref.centroid);
+            ++count;
+        }
+    };
+    struct Task {
+        uint32_t node;
+        uint32_t depth;
+        Range range;
+    };
+
+    Range rootRange;
+    for (const BuildRef& ref : buildRefs_) {
+        rootRange.add(ref);
+    }
+    std::vector<Task> tasks;
+    tasks.push_back(Task{0, 0, rootRange});
+    nodes_.reserve(2 * (ids.size() / kMaxLeafItems + 1));
+    nodes_.push_back(Node{glm::vec3(0.0f), glm::vec3(0.0f), 0, itemCount_, kNone, true});
+
+    while (!tasks.empty()) {
+        const Task task = tasks.back();
+        tasks.pop_back();
+        const uint32_t first = nodes_[task.node].first;
+        const uint32_t count = nodes_[task.node].count;
+        const Range& range = task.range;
+        nodes_[task.node].min = range.min;
+        nodes_[task.node].max = range.max;
+
+        if (count <= kMaxLeafItems || task.depth >= kMaxDepth) {
+            continue;
+        }
+
+        const glm::vec3 centroidExtent = range.centroidMax - range.centroidMin;
+        int axis = 0;
+        if (centroidExtent.y > centroidExtent[axis]) {
+            axis = 1;
+        }
+        if (centroidExtent.z > centroidExtent[axis]) {
+            axis = 2;
+        }
+        if (centroidExtent[axis] <= 0.0f) {
+            continue; // Every centroid coincides; no plane can separate them.
+        }
+
+        // Bin centroids along the widest axis and sweep the bin boundaries for the cheapest split.
+        std::array<Range, kBinCount> bins{};
+        const float binScale = static_cast<float>(kBinCount) / centroidExtent[axis];
+        const float centroidStart = range.centroidMin[axis];
+        auto binOf = [&](const BuildRef& ref) {
+            const uint32_t bin = static_cast<uint32_t>((ref.centroid[axis] - centroidStart) * binScale);
+            return std::min(bin, kBinCount - 1);
+        };
+        for (uint32_t i = first; i < first + count; ++i) {
+            bins[binOf(buildRefs_[i])].add(buildRefs_[i]);
+        }
+
+        std::array<Range, kBinCount - 1> leftRanges{};
+        Range accumulated;
+        for (uint32_t i = 0; i + 1 < kBinCount; ++i) {
+            accumulated.add(bins[i]);
+            leftRanges[i] = accumulated;
+        }
+        float bestCost = std::numeric_limits<float>::max();
+        uint32_t bestSplit = 0;
+        Range bestRight;
+        accumulated = Range{};
+        for (uint32_t i = kBinCount - 1; i > 0; --i) {
+            accumulated.add(bins[i]);
+            const Range& left = leftRanges[i - 1];
+            if (left.count == 0 || accumulated.count == 0) {
+                continue;
+            }
+            const float cost = surfaceArea(left.min, left.max) * static_cast<float>(left.count) +
+                               surfaceArea(accumulated.min, accumulated.max) * static_cast<float>(accumulated.count);
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestSplit = i;
+                bestRight = accumulated;
+            }
+        }
+
+        // Keep small nodes as leaves when splitting would not beat testing every item.
+        const float leafCost = surfaceArea(range.min, range.max) * static_cast<float>(count);
+        if (count <= 2 * kMaxLeafItems && bestCost >= leafCost) {
+            continue;
+        }
+
+        const auto begin = buildRefs_.begin() + first;
+        Range leftRange;
+        Range rightRange;
+        uint32_t leftCount = 0;
+        if (bestSplit > 0) {
+            std::partition(begin, begin + count, [&](const BuildRef& ref) { return binOf(ref) < bestSplit; });
+            leftRange = leftRanges[bestSplit - 1];
+            rightRange = bestRight;
+            leftCount = leftRange.count;
+        } else {
+            // Binning could not separate the items; fall back to a median split.
+            leftCount = count / 2;
+            std::nth_element(begin, begin + leftCount, begin + count,
+                             [&](const BuildRef& a, const BuildRef& b) { return a.centroid[axis] < b.centroid[axis]; });
+            for (uint32_t i = 0; i < count; ++i) {
+                (i < leftCount ? leftRange : rightRange).add(begin[i]);
+            }
+        }
+
+        const uint32_t left = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{glm::vec3(0.0f), glm::vec3(0.0f), first, leftCount, task.node, true});
+        nodes_.push_back(Node{glm::vec3(0.0f), glm::vec3(0.0f), first + leftCount, count - leftCount, task.node, true});
+        nodes_[task.node].first = left;
+        nodes_[task.node].count = 0;
+        nodes_[task.node].leaf = false;
+        tasks.push_back(Task{left, task.depth + 1, leftRange});
+        tasks.push_back(Task{left + 1, task.depth + 1, rightRange});
+    }
+
+    items_.resize(buildRefs_.size());
+    for (size_t i = 0; i < buildRefs_.size(); ++i) {
+        items_[i] = buildRefs_[i].id;
+    }
+    for (uint32_t n = 0; n < nodes_.size(); ++n) {
+        if (nodes_[n].leaf) {
+            for (uint32_t i = nodes_[n].first; i < nodes_[n].first + nodes_[n].count; ++i) {
+                leafOf_[items_[i]] = n;
+            }
+        }
+    }
+}
+
+bool ABvh::contains(uint32_t id) const {
+    return id < leafOf_.size() && leafOf_[id] != kNone;
+}
+
+void ABvh::update(uint32_t id, const glm::vec3& min, const glm::vec3& max) {
+    if (!contains(id)) {
+        return;
+    }
+    boxMin_[id] = min;
+    boxMax_[id] = max;
+    refitFrom(leafOf_[id]);
+}
+
+void ABvh::remove(uint32_t id) {
+    if (!contains(id)) {
+        return;
+    }
+    Node& leaf = nodes_[leafOf_[id]];
+    const auto begin = items_.begin() + leaf.first;
+    const auto it = std::find(begin, begin + leaf.count, id);
+    std::iter_swap(it, begin + leaf.count - 1);
+    --leaf.count;
+    --itemCount_;
+    const uint32_t leafIndex = leafOf_[id];
+    leafOf_[id] = kNone;
+    refitFrom(leafIndex);
+}
+
+void ABvh::refitFrom(uint32_t nodeIndex) {
+    for (uint32_t index = nodeIndex; index != kNone; index = nodes_[index].parent) {
+        Node& node = nodes_[index];
+        glm::vec3 min(std::numeric_limits<float>::max());
+        glm::vec3 max(std::numeric_limits<float>::lowest());
+        if (node.leaf) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                min = glm::min(min, boxMin_[items_[i]]);
+                max = glm::max(max, boxMax_[items_[i]]);
+            }
+        } else {
+            min = glm::min(nodes_[node.first].min, nodes_[node.first + 1].min);
+            max = glm::max(nodes_[node.first].max, nodes_[node.first + 1].max);
+        }
+        if (index != nodeIndex && min == node.min && max == node.max) {
+            return; // Ancestors already enclose this box.
+        }
+        node.min = min;
+        node.max = max;
+    }
+}
+
+void ABvh::queryFrustums(std::span<const AFrustum> frustums, std::span<std::vector<uint32_t>> outIds) const {
+    if (nodes_.empty() || frustums.empty()) {
+        return;
+    }
+    const uint32_t frustumCount = std::min<uint32_t>(static_cast<uint32_t>(frustums.size()), kMaxFrustums);
+
+    // Per entry: frustums still needing plane tests, and frustums already known to contain the node.
+    struct Entry {
+        uint32_t node;
+        uint32_t testMask;
+        uint32_t insideMask;
+    };
+    std::array<Entry, kStackSize> stack;
+    uint32_t top = 0;
+    const uint32_t allMask = frustumCount == 32 ? 0xFFFFFFFFu : ((1u << frustumCount) - 1u);
+    stack[top++] = Entry{0, allMask, 0};
+
+    while (top > 0) {
+        Entry entry = stack[--top];
+        const Node& node = nodes_[entry.node];
+        if (isEmptyBox(node.min, node.max)) {
+            continue;
+        }
+
+        const glm::vec3 center = (node.min + node.max) * 0.5f;
+        const glm::vec3 extents = (node.max - node.min) * 0.5f;
+        for (uint32_t f = 0; f < frustumCount; ++f) {
+            const uint32_t bit = 1u << f;
+            if (!(entry.testMask & bit)) {
+                continue;
+            }
+            switch (frustums[f].classifyAabb(center, extents)) {
+            case AFrustum::Containment::Outside:
+                entry.testMask &= ~bit;
+                break;
+            case AFrustum::Containment::Inside:
+                entry.testMask &= ~bit;
+                entry.insideMask |= bit;
+                break;
+            default:
+                break;
+            }
+        }
+        if (!(entry.testMask | entry.insideMask)) {
+            continue;
+        }
+
+        if (!node.leaf) {
+            stack[top++] = Entry{node.first + 1, entry.testMask, entry.insideMask};
+            stack[top++] = Entry{node.first, entry.testMask, entry.insideMask};
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            const uint32_t id = items_[i];
+            const glm::vec3 itemCenter = (boxMin_[id] + boxMax_[id]) * 0.5f;
+            const glm::vec3 itemExtents = (boxMax_[id] - boxMin_[id]) * 0.5f;
+            for (uint32_t f = 0; f < frustumCount; ++f) {
+                const uint32_t bit = 1u << f;
+                if ((entry.insideMask & bit) ||
+                    ((entry.testMask & bit) && frustums[f].intersectsAabb(itemCenter, itemExtents))) {
+                    outIds[f].push_back(id);
+                }
+            }
+        }
+    }
+}
+
+void ABvh::queryAabb(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& outIds) const {
+    if (nodes_.empty()) {
+        return;
+    }
+    std::array<uint32_t, kStackSize> stack;
+    uint32_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (isEmptyBox(node.min, node.max) || !overlaps(node.min, node.max, min, max)) {
+            continue;
+        }
+        if (!node.leaf) {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (overlaps(boxMin_[items_[i]], boxMax_[items_[i]], min, max)) {
+                outIds.push_back(items_[i]);
+            }
+        }
+    }
+}
+
+void ABvh::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& outIds) const {
+    if (nodes_.empty()) {
+        return;
+    }
+    std::array<uint32_t, kStackSize> stack;
+    uint32_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (isEmptyBox(node.min, node.max) || !overlapsSphere(node.min, node.max, center, radius)) {
+            continue;
+        }
+        if (!node.leaf) {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (overlapsSphere(boxMin_[items_[i]], boxMax_[items_[i]], center, radius)) {
+                outIds.push_back(items_[i]);
+            }
+        }
+    }
+}
+
+void ABvh::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& outIds) const {
+    if (nodes_.empty()) {
+        return;
+    }
+    const glm::vec3 unit = glm::normalize(direction);
+    const glm::vec3 invDirection(1.0f / unit.x, 1.0f / unit.y, 1.0f / unit.z);
+    std::array<uint32_t, kStackSize> stack;
+    uint32_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes_[stack[--top]];
+        if (isEmptyBox(node.min, node.max) || !hitsRay(node.min, node.max, origin, invDirection, maxDistance)) {
+            continue;
+        }
+        if (!node.leaf) {
+            stack[top++] = node.first + 1;
+            stack[top++] = node.first;
+            continue;
+        }
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (hitsRay(boxMin_[items_[i]], boxMax_[items_[i]], origin, invDirection, maxDistance)) {
+                outIds.push_back(items_[i]);
+            }
+        }
+    }
+}
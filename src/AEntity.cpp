@@ -1,50 +1,104 @@
 #include <AEntity>
 
-#include <glm/gtc/matrix_transform.hpp>
+#include <AMesh>
+#include <AWorld>
 
-AEntity::AEntity(const std::vector<glm::vec3>& vertices) : vertices_(vertices) {}
+bool AEntity::isValid() const {
+    return world_ && world_->isAlive(*this);
+}
+
+uint32_t AEntity::getIndex() const {
+    return world_->getIndex(*this);
+}
 
-AEntity* AEntity::createTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
-    return new AEntity({a, b, c});
+void AEntity::setMesh(const AMesh& mesh) {
+    if (isValid()) {
+        world_->setMesh(getIndex(), mesh);
+    }
 }
 
-AEntity* AEntity::createRectangle(float width, float height) {
-    const float hw = width * 0.5f;
-    const float hh = height * 0.5f;
-    // Rectangle on X-Y plane centered on origin at Z = 0.
-    std::vector<glm::vec3> verts = {
-        {-hw, -hh, 0.0f},
-        { hw, -hh, 0.0f},
-        { hw,  hh, 0.0f},
-        {-hw,  hh, 0.0f},
-    };
-    return new AEntity(verts);
+AMesh AEntity::getMesh() const {
+    return world_->getMesh(world_->getMeshIds()[getIndex()]);
 }
 
-const std::vector<glm::vec3>& AEntity::getVertices() const {
-    return vertices_;
+std::span<const glm::vec3> AEntity::getVertices() const {
+    return world_->getMeshVertices(world_->getMeshIds()[getIndex()]);
+}
+
+void AEntity::setVertices(std::span<const glm::vec3> vertices) {
+    if (isValid()) {
+        world_->setVertices(getIndex(), vertices);
+    }
 }
 
 const AEntity::Color& AEntity::getColor() const {
-    return color_;
+    return world_->getColors()[getIndex()];
 }
 
-const std::vector<AEntity::Color>& AEntity::getVertexColors() const {
-    return vertexColors_;
+std::span<const AEntity::Color> AEntity::getVertexColors() const {
+    return world_->getMeshVertexColors(world_->getMeshIds()[getIndex()]);
 }
 
 void AEntity::setPosition(const glm::vec3& pos) {
-    position_ = pos;
+    if (isValid()) {
+        world_->setPosition(getIndex(), pos);
+    }
 }
 
 const glm::vec3& AEntity::getPosition() const {
-    return position_;
+    return world_->getPositions()[getIndex()];
+}
+
+void AEntity::setRotation(const glm::quat& rotation) {
+    if (isValid()) {
+        world_->setRotation(getIndex(), rotation);
+    }
+}
+
+const glm::quat& AEntity::getRotation() const {
+    return world_->getRotations()[getIndex()];
+}
+
+void AEntity::setScale(const glm::vec3& scale) {
+    if (isValid()) {
+        world_->setScale(getIndex(), scale);
+    }
+}
+
+const glm::vec3& AEntity::getScale() const {
+    return world_->getScales()[getIndex()];
+}
+
+bool AEntity::setParent(const AEntity& parent) {
+    return world_ && world_->setParent(*this, parent);
+}
+
+AEntity AEntity::getParent() const {
+    return world_ ? world_->getParent(*this) : AEntity();
+}
+
+const glm::mat4& AEntity::getWorldMatrix() const {
+    return world_->getWorldMatrices()[getIndex()];
 }
 
 void AEntity::setColor(const Color& color) {
-    color_ = color;
+    if (isValid()) {
+        world_->setColor(getIndex(), color);
+    }
+}
+
+void AEntity::setStatic(bool isStatic) {
+    if (isValid()) {
+        world_->setStatic(getIndex(), isStatic);
+    }
+}
+
+bool AEntity::isStatic() const {
+    return world_->getStaticFlags()[getIndex()] != 0;
 }
 
 void AEntity::setVertexColors(const std::vector<Color>& colors) {
-    vertexColors_ = colors;
+    if (isValid()) {
+        world_->setVertexColors(getIndex(), colors);
+    }
 }
@@ -0,0 +1,29 @@
+#include <AFloatingText>
+
+#include <AWorld>
+
+void AFloatingText::setText(std::string_view value) {
+    text_.assign(value);
+    touch();
+}
+
+void AFloatingText::setWorldPosition(const glm::vec3& pos) {
+    worldPosition_ = pos;
+    touch();
+}
+
+void AFloatingText::setPixelHeight(int h) {
+    pixelHeight_ = h;
+    touch();
+}
+
+void AFloatingText::setColor(const AEntity::Color& c) {
+    color_ = c;
+    touch();
+}
+
+void AFloatingText::touch() {
+    if (world_) {
+        world_->markTextsChanged();
+    }
+}
@@ -0,0 +1,62 @@
+#include <AFrameArena>
+
+#include <algorithm>
+
+AFrameArena::AFrameArena(size_t frameCount, size_t blockSize)
+    : buffers_(std::max<size_t>(frameCount, 1)), blockSize_(std::max<size_t>(blockSize, 256)) {}
+
+void AFrameArena::beginFrame() {
+    current_ = (current_ + 1) % buffers_.size();
+    Buffer& buffer = buffers_[current_];
+    if (buffer.blocks.size() > 1) {
+        // Size the buffer for what it needed last time so the next frame fits in one block.
+        size_t total = 0;
+        for (const Block& block : buffer.blocks) {
+            total += block.size;
+        }
+        buffer.blocks.clear();
+        buffer.blocks.push_back(allocateBlock(total));
+    }
+    buffer.block = 0;
+    buffer.offset = 0;
+    buffer.used = 0;
+}
+
+AFrameArena& AFrameArena::current() {
+    thread_local AFrameArena arena;
+    return arena;
+}
+
+void* AFrameArena::do_allocate(size_t bytes, size_t alignment) {
+    Buffer& buffer = buffers_[current_];
+    for (; buffer.block < buffer.blocks.size(); ++buffer.block, buffer.offset = 0) {
+        const Block& block = buffer.blocks[buffer.block];
+        const uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+        const uintptr_t aligned = (base + buffer.offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        const size_t end = static_cast<size_t>(aligned - base) + bytes;
+        if (end <= block.size) {
+            buffer.used += end - buffer.offset;
+            buffer.offset = end;
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+
+    // Out of space: add a block that fits the request whatever its alignment.
+    buffer.blocks.push_back(allocateBlock(std::max(blockSize_, bytes + alignment)));
+    buffer.block = buffer.blocks.size() - 1;
+    buffer.offset = 0;
+    return do_allocate(bytes, alignment);
+}
+
+void AFrameArena::do_deallocate(void*, size_t, size_t) {
+    // Memory comes back all at once when its buffer is rewound.
+}
+
+bool AFrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+AFrameArena::Block AFrameArena::allocateBlock(size_t size) {
+    ++blockAllocations_;
+    return Block{std::unique_ptr<std::byte[]>(new std::byte[size]), size}; // Left uninitialized.
+}
@@ -0,0 +1,104 @@
+#include <AFramePipeline>
+
+#include <AFrameArena>
+#include <ARenderTimeTracker>
+#include <AWindow>
+#include <algorithm>
+
+AFramePipeline::AFramePipeline(size_t depth)
+    : packets_(std::max<size_t>(depth, 1)) {
+    renderThread_ = std::thread(&AFramePipeline::renderLoop, this);
+}
+
+AFramePipeline::~AFramePipeline() {
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    packetQueued_.notify_all();
+    if (renderThread_.joinable()) {
+        renderThread_.join();
+    }
+}
+
+void AFramePipeline::addWindow(AWindow& window) {
+    flush();
+    windows_.push_back(&window);
+}
+
+void AFramePipeline::setTimeTracker(ARenderTimeTracker* tracker) {
+    flush();
+    tracker_ = tracker;
+}
+
+void AFramePipeline::setDepth(size_t depth) {
+    flush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Both counters are equal after flush(), so resizing cannot strand a queued packet.
+    packets_.resize(std::max<size_t>(depth, 1));
+}
+
+size_t AFramePipeline::getDepth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return packets_.size();
+}
+
+void AFramePipeline::submit() {
+    size_t slot = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        packetDone_.wait(lock, [this] { return submitted_ - completed_ < packets_.size(); });
+        slot = static_cast<size_t>(submitted_ % packets_.size());
+    }
+
+    // The render thread never reads a slot until it is published below, so build without the lock.
+    FramePacket& packet = packets_[slot];
+    packet.lists.resize(windows_.size());
+    for (size_t i = 0; i < windows_.size(); ++i) {
+        windows_[i]->buildFrame(packet.lists[i]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++submitted_;
+    }
+    packetQueued_.notify_one();
+
+    // Whatever the caller allocated from its arena this frame stays valid through the next one.
+    AFrameArena::current().beginFrame();
+}
+
+void AFramePipeline::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    packetDone_.wait(lock, [this] { return completed_ == submitted_; });
+}
+
+void AFramePipeline::renderLoop() {
+    for (;;) {
+        size_t slot = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            packetQueued_.wait(lock, [this] { return stopping_ || completed_ < submitted_; });
+            if (completed_ == submitted_) {
+                return; // Stopping with nothing left to draw.
+            }
+            slot = static_cast<size_t>(completed_ % packets_.size());
+        }
+
+        const FramePacket& packet = packets_[slot];
+        for (size_t i = 0; i < windows_.size() && i < packet.lists.size(); ++i) {
+            if (tracker_) {
+                tracker_->timePresent(*windows_[i], packet.lists[i]);
+            } else {
+                windows_[i]->presentFrame(packet.lists[i]);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++completed_;
+        }
+        packetDone_.notify_all();
+    }
+}
@@ -13,18 +13,14 @@ AFreeCamera::AFreeCamera(AViewport& viewport, const glm::vec3& position, const g
     updateMatrices();
 }
 
-void AFreeCamera::dispatchEvent(const std::shared_ptr<AEvent>& event) {
-    if (!event) {
-        return;
-    }
-
+void AFreeCamera::dispatchEvent(const AEvent& event) {
     if (!inputEnabled_) {
         return;
     }
 
-    if (event->is<AEvent::KeyPressed>()) {
-        handleKeyPressed(event->getIf<AEvent::KeyPressed>()->scancode);
-    } else if (const auto* moveEvent = event->getIf<AEvent::MouseMoved>()) {
+    if (const auto* keyPressed = event.getIf<AEvent::KeyPressed>()) {
+        handleKeyPressed(keyPressed->scancode);
+    } else if (const auto* moveEvent = event.getIf<AEvent::MouseMoved>()) {
         handleMouseMoved(moveEvent);
     }
 }
@@ -0,0 +1,67 @@
+#include <AFrustum>
+
+#include <cmath>
+
+AFrustum::AFrustum(const glm::mat4& viewProjection) {
+    setFromMatrix(viewProjection);
+}
+
+void AFrustum::setFromMatrix(const glm::mat4& viewProjection) {
+    // Gribb/Hartmann: each plane is the last row of the matrix plus or minus one of the others.
+    const glm::mat4& m = viewProjection;
+    const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes_[Left] = row3 + row0;
+    planes_[Right] = row3 - row0;
+    planes_[Bottom] = row3 + row1;
+    planes_[Top] = row3 - row1;
+    planes_[Near] = row3 + row2;
+    planes_[Far] = row3 - row2;
+
+    for (auto& plane : planes_) {
+        const float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) {
+            plane /= length;
+        }
+    }
+}
+
+bool AFrustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (const auto& plane : planes_) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AFrustum::intersectsAabb(const glm::vec3& center, const glm::vec3& extents) const {
+    for (const auto& plane : planes_) {
+        const glm::vec3 normal(plane);
+        // Projected half-size of the box onto the plane normal.
+        const float reach = extents.x * std::abs(normal.x) + extents.y * std::abs(normal.y) + extents.z * std::abs(normal.z);
+        if (glm::dot(normal, center) + plane.w < -reach) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AFrustum::Containment AFrustum::classifyAabb(const glm::vec3& center, const glm::vec3& extents) const {
+    bool straddles = false;
+    for (const auto& plane : planes_) {
+        const glm::vec3 normal(plane);
+        const float reach = extents.x * std::abs(normal.x) + extents.y * std::abs(normal.y) + extents.z * std::abs(normal.z);
+        const float distance = glm::dot(normal, center) + plane.w;
+        if (distance < -reach) {
+            return Containment::Outside;
+        }
+        if (distance < reach) {
+            straddles = true;
+        }
+    }
+    return straddles ? Containment::Intersects : Containment::Inside;
+}
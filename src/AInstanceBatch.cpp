@@ -0,0 +1,28 @@
+#include <AInstanceBatch>
+
+#include <AMesh>
+#include <AWorld>
+
+bool AInstanceBatch::isValid() const {
+    return world_ && world_->isAlive(*this);
+}
+
+AMesh AInstanceBatch::getMesh() const {
+    return world_->getMesh(world_->getInstanceBatches()[id_].meshId);
+}
+
+uint32_t AInstanceBatch::getCount() const {
+    return static_cast<uint32_t>(world_->getInstanceBatches()[id_].instances.size());
+}
+
+std::span<const AInstance> AInstanceBatch::getInstances() const {
+    return world_->getInstanceBatches()[id_].instances;
+}
+
+bool AInstanceBatch::setTransforms(uint32_t first, std::span<const glm::mat4> transforms) {
+    return world_ && world_->setInstanceTransforms(*this, first, transforms);
+}
+
+bool AInstanceBatch::setColors(uint32_t first, std::span<const AEntity::Color> colors) {
+    return world_ && world_->setInstanceColors(*this, first, colors);
+}
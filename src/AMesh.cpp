@@ -0,0 +1,27 @@
+#include <AMesh>
+
+#include <AWorld>
+
+bool AMesh::isValid() const {
+    return world_ && world_->isAlive(*this);
+}
+
+std::span<const glm::vec3> AMesh::getVertices() const {
+    return world_->getMeshVertices(id_);
+}
+
+std::span<const uint32_t> AMesh::getIndices() const {
+    return world_->getMeshIndices(id_);
+}
+
+std::span<const AEntity::Color> AMesh::getVertexColors() const {
+    return world_->getMeshVertexColors(id_);
+}
+
+uint32_t AMesh::getLodCount() const {
+    return world_->getMeshes()[id_].lodCount;
+}
+
+uint32_t AMesh::getEntityCount() const {
+    return world_->getMeshes()[id_].entityCount;
+}
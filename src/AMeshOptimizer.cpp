@@ -0,0 +1,208 @@
+#include <AMeshOptimizer>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+
+// Tuning constants from Forsyth's "Linear-Speed Vertex Cache Optimisation".
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+constexpr uint32_t kNoTriangle = 0xFFFFFFFFu;
+
+constexpr uint32_t kValenceTableSize = 32;
+
+struct ScoreTables {
+    std::array<float, AMeshOptimizer::kCacheSize> cache{};
+    std::array<float, kValenceTableSize> valence{};
+
+    ScoreTables() {
+        for (uint32_t i = 0; i < cache.size(); ++i) {
+            // The last triangle's vertices get a fixed score so the next pick is not forced to share an edge.
+            if (i < 3) {
+                cache[i] = kLastTriangleScore;
+            } else {
+                const float scale = 1.0f / static_cast<float>(AMeshOptimizer::kCacheSize - 3);
+                cache[i] = std::pow(1.0f - static_cast<float>(i - 3) * scale, kCacheDecayPower);
+            }
+        }
+        for (uint32_t i = 1; i < valence.size(); ++i) {
+            valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+        }
+    }
+};
+
+const ScoreTables& scoreTables() {
+    static const ScoreTables tables;
+    return tables;
+}
+
+} // namespace
+
+float AMeshOptimizer::vertexScore(uint32_t vertex) const {
+    const uint32_t remaining = remaining_[vertex];
+    if (remaining == 0) {
+        return -1.0f;
+    }
+    const ScoreTables& tables = scoreTables();
+    const int32_t position = cachePosition_[vertex];
+    float score = position >= 0 ? tables.cache[static_cast<uint32_t>(position)] : 0.0f;
+    // Finishing off vertices with few triangles left avoids leaving lone triangles behind.
+    score += remaining < kValenceTableSize
+                 ? tables.valence[remaining]
+                 : kValenceBoostScale * std::pow(static_cast<float>(remaining), -kValenceBoostPower);
+    return score;
+}
+
+bool AMeshOptimizer::optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount) {
+    if (indices.size() % 3 != 0) {
+        return false;
+    }
+    for (uint32_t index : indices) {
+        if (index >= vertexCount) {
+            return false;
+        }
+    }
+    const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (triangleCount < 2) {
+        return true;
+    }
+
+    // Triangle adjacency per vertex as one flat array; the first remaining_[v] entries of a
+    // vertex's range are the triangles not yet emitted.
+    remaining_.assign(vertexCount, 0);
+    for (uint32_t index : indices) {
+        ++remaining_[index];
+    }
+    adjacencyStart_.resize(vertexCount + 1);
+    uint32_t offset = 0;
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        adjacencyStart_[v] = offset;
+        offset += remaining_[v];
+    }
+    adjacencyStart_[vertexCount] = offset;
+    adjacency_.resize(indices.size());
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        for (uint32_t k = 0; k < 3; ++k) {
+            adjacency_[adjacencyStart_[indices[t * 3 + k]]++] = t;
+        }
+    }
+    for (uint32_t v = vertexCount; v > 0; --v) {
+        adjacencyStart_[v] = adjacencyStart_[v - 1];
+    }
+    adjacencyStart_[0] = 0;
+
+    cachePosition_.assign(vertexCount, -1);
+    vertexScores_.resize(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        vertexScores_[v] = vertexScore(v);
+    }
+    triangleScores_.resize(triangleCount);
+    emitted_.assign(triangleCount, 0);
+    uint32_t best = 0;
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        triangleScores_[t] = vertexScores_[indices[t * 3]] + vertexScores_[indices[t * 3 + 1]] + vertexScores_[indices[t * 3 + 2]];
+        if (triangleScores_[t] > triangleScores_[best]) {
+            best = t;
+        }
+    }
+
+    // LRU cache simulation; three extra entries hold vertices pushed out by the newest triangle
+    // so their scores (and their triangles') are lowered too.
+    std::array<uint32_t, kCacheSize + 3> cache{};
+    std::array<uint32_t, kCacheSize + 3> nextCache{};
+    uint32_t cacheCount = 0;
+    uint32_t scanCursor = 0;
+
+    output_.clear();
+    output_.reserve(indices.size());
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (best == kNoTriangle) {
+            // Nothing in the cache has triangles left: restart from the next untouched triangle.
+            while (emitted_[scanCursor]) {
+                ++scanCursor;
+            }
+            best = scanCursor;
+        }
+
+        const uint32_t* triangle = &indices[best * 3];
+        emitted_[best] = 1;
+        output_.insert(output_.end(), triangle, triangle + 3);
+
+        uint32_t nextCount = 0;
+        for (uint32_t k = 0; k < 3; ++k) {
+            const uint32_t v = triangle[k];
+            uint32_t* first = &adjacency_[adjacencyStart_[v]];
+            uint32_t* last = first + remaining_[v] - 1;
+            for (uint32_t* it = first; it <= last; ++it) {
+                if (*it == best) {
+                    std::swap(*it, *last);
+                    break;
+                }
+            }
+            --remaining_[v];
+            nextCache[nextCount++] = v;
+        }
+        // Every old entry fits; those pushed past kCacheSize lose their cache bonus below.
+        for (uint32_t i = 0; i < cacheCount; ++i) {
+            const uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                nextCache[nextCount++] = v;
+            }
+        }
+
+        for (uint32_t i = 0; i < nextCount; ++i) {
+            const uint32_t v = nextCache[i];
+            cachePosition_[v] = i < kCacheSize ? static_cast<int32_t>(i) : -1;
+            const float score = vertexScore(v);
+            const float delta = score - vertexScores_[v];
+            vertexScores_[v] = score;
+            const uint32_t* adjacent = &adjacency_[adjacencyStart_[v]];
+            for (uint32_t a = 0; a < remaining_[v]; ++a) {
+                triangleScores_[adjacent[a]] += delta;
+            }
+        }
+
+        // Only triangles touching the cache changed, so the next pick is searched among them.
+        best = kNoTriangle;
+        float bestScore = -1.0f;
+        for (uint32_t i = 0; i < nextCount; ++i) {
+            const uint32_t v = nextCache[i];
+            const uint32_t* adjacent = &adjacency_[adjacencyStart_[v]];
+            for (uint32_t a = 0; a < remaining_[v]; ++a) {
+                if (triangleScores_[adjacent[a]] > bestScore) {
+                    bestScore = triangleScores_[adjacent[a]];
+                    best = adjacent[a];
+                }
+            }
+        }
+
+        cache = nextCache;
+        cacheCount = nextCount < kCacheSize ? nextCount : kCacheSize;
+    }
+
+    std::copy(output_.begin(), output_.end(), indices.begin());
+    return true;
+}
+
+float AMeshOptimizer::computeAcmr(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+    // A vertex is cached if fewer than cacheSize misses happened since it was loaded (FIFO).
+    std::vector<int64_t> loadedAt(vertexCount, -static_cast<int64_t>(cacheSize) - 1);
+    int64_t misses = 0;
+    for (uint32_t index : indices) {
+        if (index >= vertexCount) {
+            continue;
+        }
+        if (misses - loadedAt[index] > static_cast<int64_t>(cacheSize)) {
+            loadedAt[index] = misses;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
@@ -0,0 +1,260 @@
+#include <AMeshSimplifier>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Border planes are weighted well above surface planes so open edges (e.g. terrain patch
+// seams) stay put while the interior is simplified.
+constexpr double kBorderWeight = 10.0;
+
+glm::dvec3 toDouble(const glm::vec3& v) {
+    return glm::dvec3(v.x, v.y, v.z);
+}
+
+} // namespace
+
+void AMeshSimplifier::addPlane(Quadric& q, const glm::dvec3& n, double d, double weight) {
+    q[0] += weight * n.x * n.x;
+    q[1] += weight * n.x * n.y;
+    q[2] += weight * n.x * n.z;
+    q[3] += weight * n.x * d;
+    q[4] += weight * n.y * n.y;
+    q[5] += weight * n.y * n.z;
+    q[6] += weight * n.y * d;
+    q[7] += weight * n.z * n.z;
+    q[8] += weight * n.z * d;
+    q[9] += weight * d * d;
+    q[10] += weight;
+}
+
+double AMeshSimplifier::evaluate(const Quadric& q, const glm::vec3& p) {
+    const double x = p.x;
+    const double y = p.y;
+    const double z = p.z;
+    const double error = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+                         q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+                         q[7] * z * z + 2.0 * q[8] * z + q[9];
+    return q[10] > 0.0 ? std::max(error, 0.0) / q[10] : 0.0;
+}
+
+void AMeshSimplifier::collectEdges(const std::vector<uint32_t>& indices, uint32_t vertexCount) {
+    edges_.clear();
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        for (size_t k = 0; k < 3; ++k) {
+            const uint32_t a = indices[t + k];
+            const uint32_t b = indices[t + (k + 1) % 3];
+            edges_.push_back(Edge{std::min(a, b), std::max(a, b), false});
+        }
+    }
+    std::sort(edges_.begin(), edges_.end(), [](const Edge& l, const Edge& r) {
+        return l.a != r.a ? l.a < r.a : l.b < r.b;
+    });
+
+    border_.assign(vertexCount, 0);
+    size_t unique = 0;
+    for (size_t i = 0; i < edges_.size();) {
+        size_t end = i + 1;
+        while (end < edges_.size() && edges_[end].a == edges_[i].a && edges_[end].b == edges_[i].b) {
+            ++end;
+        }
+        Edge edge = edges_[i];
+        edge.border = end - i == 1;
+        if (edge.border) {
+            border_[edge.a] = 1;
+            border_[edge.b] = 1;
+        }
+        edges_[unique++] = edge;
+        i = end;
+    }
+    edges_.resize(unique);
+}
+
+bool AMeshSimplifier::flipsTriangle(std::span<const glm::vec3> vertices,
+                                    const std::vector<uint32_t>& indices,
+                                    uint32_t from,
+                                    uint32_t to) const {
+    for (uint32_t a = adjacencyStart_[from]; a < adjacencyStart_[from + 1]; ++a) {
+        const uint32_t* triangle = &indices[adjacency_[a] * 3];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+            continue; // Collapses away with the edge.
+        }
+        glm::vec3 moved[3];
+        for (int k = 0; k < 3; ++k) {
+            moved[k] = vertices[triangle[k] == from ? to : triangle[k]];
+        }
+        const glm::vec3 before = glm::cross(vertices[triangle[1]] - vertices[triangle[0]], vertices[triangle[2]] - vertices[triangle[0]]);
+        const glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+        // Refuse flipped or nearly collapsed results.
+        if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+float AMeshSimplifier::simplify(std::span<const glm::vec3> vertices,
+                                std::span<const uint32_t> indices,
+                                uint32_t targetIndexCount,
+                                float maxError,
+                                std::vector<uint32_t>& outIndices) {
+    outIndices.assign(indices.begin(), indices.end());
+    const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    if (outIndices.size() % 3 != 0 || outIndices.size() <= targetIndexCount) {
+        return 0.0f;
+    }
+
+    // Quadrics of the original surface; collapses accumulate them so error stays measured
+    // against the input rather than the previous pass.
+    quadrics_.assign(vertexCount, Quadric{});
+    collectEdges(outIndices, vertexCount);
+    for (size_t t = 0; t < outIndices.size(); t += 3) {
+        const glm::dvec3 p0 = toDouble(vertices[outIndices[t]]);
+        const glm::dvec3 p1 = toDouble(vertices[outIndices[t + 1]]);
+        const glm::dvec3 p2 = toDouble(vertices[outIndices[t + 2]]);
+        const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+        const double length = glm::length(normal);
+        if (length <= 0.0) {
+            continue;
+        }
+        const glm::dvec3 n = normal / length;
+        const double area = length * 0.5;
+        for (size_t k = 0; k < 3; ++k) {
+            addPlane(quadrics_[outIndices[t + k]], n, -glm::dot(n, p0), area);
+        }
+
+        for (size_t k = 0; k < 3; ++k) {
+            const uint32_t a = outIndices[t + k];
+            const uint32_t b = outIndices[t + (k + 1) % 3];
+            const Edge key{std::min(a, b), std::max(a, b), false};
+            const auto it = std::lower_bound(edges_.begin(), edges_.end(), key, [](const Edge& l, const Edge& r) {
+                return l.a != r.a ? l.a < r.a : l.b < r.b;
+            });
+            if (it == edges_.end() || !it->border) {
+                continue;
+            }
+            // Plane through the border edge, perpendicular to the triangle.
+            const glm::dvec3 pa = toDouble(vertices[a]);
+            const glm::dvec3 edge = toDouble(vertices[b]) - pa;
+            const glm::dvec3 side = glm::cross(edge, n);
+            const double sideLength = glm::length(side);
+            if (sideLength <= 0.0) {
+                continue;
+            }
+            const glm::dvec3 sn = side / sideLength;
+            const double weight = glm::dot(edge, edge) * kBorderWeight;
+            addPlane(quadrics_[a], sn, -glm::dot(sn, pa), weight);
+            addPlane(quadrics_[b], sn, -glm::dot(sn, pa), weight);
+        }
+    }
+
+    const double maxErrorSq = static_cast<double>(maxError) * static_cast<double>(maxError);
+    double reached = 0.0;
+    while (outIndices.size() > targetIndexCount) {
+        collectEdges(outIndices, vertexCount);
+
+        // Cheapest direction of every edge. Border vertices only slide along their border.
+        collapses_.clear();
+        for (const Edge& edge : edges_) {
+            Quadric sum = quadrics_[edge.a];
+            for (size_t i = 0; i < sum.size(); ++i) {
+                sum[i] += quadrics_[edge.b][i];
+            }
+            const bool canMoveA = !border_[edge.a] || edge.border;
+            const bool canMoveB = !border_[edge.b] || edge.border;
+            Collapse best{0, 0, std::numeric_limits<double>::max()};
+            if (canMoveA) {
+                best = Collapse{edge.a, edge.b, evaluate(sum, vertices[edge.b])};
+            }
+            if (canMoveB) {
+                const double error = evaluate(sum, vertices[edge.a]);
+                if (error < best.error) {
+                    best = Collapse{edge.b, edge.a, error};
+                }
+            }
+            if (best.error <= maxErrorSq) {
+                collapses_.push_back(best);
+            }
+        }
+        if (collapses_.empty()) {
+            break;
+        }
+        std::sort(collapses_.begin(), collapses_.end(), [](const Collapse& l, const Collapse& r) {
+            return l.error < r.error;
+        });
+
+        // Triangles around each vertex, for flip checks and neighbourhood locking.
+        adjacencyStart_.assign(vertexCount + 1, 0);
+        for (uint32_t index : outIndices) {
+            ++adjacencyStart_[index + 1];
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            adjacencyStart_[v + 1] += adjacencyStart_[v];
+        }
+        adjacency_.resize(outIndices.size());
+        for (size_t i = 0; i < outIndices.size(); ++i) {
+            adjacency_[adjacencyStart_[outIndices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+        for (uint32_t v = vertexCount; v > 0; --v) {
+            adjacencyStart_[v] = adjacencyStart_[v - 1];
+        }
+        adjacencyStart_[0] = 0;
+
+        // Independent collapses only: a vertex whose neighbourhood changed this pass waits for
+        // the next one, so every check below sees current positions.
+        remap_.resize(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            remap_[v] = v;
+        }
+        locked_.assign(vertexCount, 0);
+        const size_t trianglesToRemove = (outIndices.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        for (const Collapse& collapse : collapses_) {
+            if (removed >= trianglesToRemove) {
+                break;
+            }
+            if (locked_[collapse.from] || locked_[collapse.to]) {
+                continue;
+            }
+            if (flipsTriangle(vertices, outIndices, collapse.from, collapse.to)) {
+                continue;
+            }
+
+            remap_[collapse.from] = collapse.to;
+            for (size_t i = 0; i < quadrics_[collapse.to].size(); ++i) {
+                quadrics_[collapse.to][i] += quadrics_[collapse.from][i];
+            }
+            for (uint32_t a = adjacencyStart_[collapse.from]; a < adjacencyStart_[collapse.from + 1]; ++a) {
+                const uint32_t* triangle = &outIndices[adjacency_[a] * 3];
+                for (int k = 0; k < 3; ++k) {
+                    locked_[triangle[k]] = 1;
+                }
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+                    ++removed;
+                }
+            }
+            locked_[collapse.to] = 1;
+            reached = std::max(reached, collapse.error);
+        }
+        if (removed == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t t = 0; t < outIndices.size(); t += 3) {
+            const uint32_t a = remap_[outIndices[t]];
+            const uint32_t b = remap_[outIndices[t + 1]];
+            const uint32_t c = remap_[outIndices[t + 2]];
+            if (a == b || b == c || a == c) {
+                continue;
+            }
+            outIndices[write++] = a;
+            outIndices[write++] = b;
+            outIndices[write++] = c;
+        }
+        outIndices.resize(write);
+    }
+    return static_cast<float>(std::sqrt(reached));
+}
@@ -0,0 +1,223 @@
+#include <AParticleSystem>
+#include <AWorkerPool>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AP_PARTICLES_SSE 1
+#endif
+
+namespace {
+
+// Below this many particles per range, waking a worker costs more than it saves.
+constexpr uint32_t kMinParticlesPerRange = 16384;
+
+uint32_t roundUp4(uint32_t value) {
+    return (value + 3u) & ~3u;
+}
+
+#if AP_PARTICLES_SSE
+float horizontalMin(__m128 v) {
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
+}
+
+float horizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+} // namespace
+
+AParticleSystem::AParticleSystem(uint32_t capacity) : capacity_(capacity) {
+    for (std::vector<float>* array : {&px_, &py_, &pz_, &vx_, &vy_, &vz_, &age_, &life_}) {
+        array->assign(capacity, 0.0f);
+    }
+}
+
+void AParticleSystem::update(float deltaTime) {
+    const auto startTime = std::chrono::steady_clock::now();
+    stats_ = Stats{};
+    const uint32_t before = count_;
+
+    // Ranges start on multiples of four so only the last one has a scalar tail.
+    AWorkerPool& pool = AWorkerPool::shared();
+    uint32_t ranges = 1;
+    if (workerCount_ > 0 && count_ >= 2 * kMinParticlesPerRange) {
+        ranges = std::min({workerCount_ + 1, pool.getThreadCount(), count_ / kMinParticlesPerRange});
+    }
+    const uint32_t rangeSize = roundUp4((count_ + ranges - 1) / ranges);
+    rangeStarts_.resize(ranges + 1);
+    for (uint32_t r = 0; r <= ranges; ++r) {
+        rangeStarts_[r] = std::min(count_, r * rangeSize);
+    }
+    rangeResults_.assign(ranges, RangeResult{});
+
+    // One pool chunk per range, so range boundaries keep their alignment.
+    pool.parallelFor(ranges, ranges, [&](size_t, size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+            simulateRange(rangeStarts_[r], rangeStarts_[r + 1], deltaTime, rangeResults_[r]);
+        }
+    });
+
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    for (const RangeResult& result : rangeResults_) {
+        boundsMin = glm::min(boundsMin, result.boundsMin);
+        boundsMax = glm::max(boundsMax, result.boundsMax);
+    }
+    // Bounds still include this frame's expired particles, which only makes them conservative.
+    expire();
+    stats_.expired = before - count_;
+
+    // Only whole particles are emitted; the fraction carries over unless the system is full.
+    emitAccumulator_ += emitter_.rate * deltaTime;
+    const auto due = static_cast<uint32_t>(emitAccumulator_);
+    emitAccumulator_ -= static_cast<float>(due);
+    const uint32_t emitted = std::min(due + pendingBurst_, capacity_ - count_);
+    if (emitted < due + pendingBurst_) {
+        emitAccumulator_ = 0.0f;
+    }
+    pendingBurst_ = 0;
+    const uint32_t firstNew = count_;
+    emit(emitted);
+    stats_.emitted = emitted;
+    for (uint32_t i = firstNew; i < count_; ++i) {
+        const glm::vec3 position(px_[i], py_[i], pz_[i]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+
+    if (count_ == 0) {
+        boundsMin = emitter_.position;
+        boundsMax = emitter_.position;
+    }
+    const float radius = 0.5f * std::max(appearance_.startSize, appearance_.endSize);
+    boundsMin_ = boundsMin - glm::vec3(radius);
+    boundsMax_ = boundsMax + glm::vec3(radius);
+    stats_.updateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void AParticleSystem::simulateRange(uint32_t begin, uint32_t end, float deltaTime, RangeResult& out) {
+    const float damping = std::max(0.0f, 1.0f - drag_ * deltaTime);
+    const glm::vec3 gravityStep = gravity_ * deltaTime;
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    uint32_t i = begin;
+
+#if AP_PARTICLES_SSE
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 damp = _mm_set1_ps(damping);
+    const __m128 gx = _mm_set1_ps(gravityStep.x);
+    const __m128 gy = _mm_set1_ps(gravityStep.y);
+    const __m128 gz = _mm_set1_ps(gravityStep.z);
+    __m128 minX = _mm_set1_ps(std::numeric_limits<float>::max());
+    __m128 minY = minX;
+    __m128 minZ = minX;
+    __m128 maxX = _mm_set1_ps(-std::numeric_limits<float>::max());
+    __m128 maxY = maxX;
+    __m128 maxZ = maxX;
+    for (; i + 4 <= end; i += 4) {
+        const __m128 vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vx_[i]), damp), gx);
+        const __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vy_[i]), damp), gy);
+        const __m128 vz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&vz_[i]), damp), gz);
+        const __m128 x = _mm_add_ps(_mm_loadu_ps(&px_[i]), _mm_mul_ps(vx, dt));
+        const __m128 y = _mm_add_ps(_mm_loadu_ps(&py_[i]), _mm_mul_ps(vy, dt));
+        const __m128 z = _mm_add_ps(_mm_loadu_ps(&pz_[i]), _mm_mul_ps(vz, dt));
+        _mm_storeu_ps(&vx_[i], vx);
+        _mm_storeu_ps(&vy_[i], vy);
+        _mm_storeu_ps(&vz_[i], vz);
+        _mm_storeu_ps(&px_[i], x);
+        _mm_storeu_ps(&py_[i], y);
+        _mm_storeu_ps(&pz_[i], z);
+        _mm_storeu_ps(&age_[i], _mm_add_ps(_mm_loadu_ps(&age_[i]), dt));
+        minX = _mm_min_ps(minX, x);
+        minY = _mm_min_ps(minY, y);
+        minZ = _mm_min_ps(minZ, z);
+        maxX = _mm_max_ps(maxX, x);
+        maxY = _mm_max_ps(maxY, y);
+        maxZ = _mm_max_ps(maxZ, z);
+    }
+    boundsMin = glm::vec3(horizontalMin(minX), horizontalMin(minY), horizontalMin(minZ));
+    boundsMax = glm::vec3(horizontalMax(maxX), horizontalMax(maxY), horizontalMax(maxZ));
+#endif
+    // Scalar tail (or everything without SSE).
+    for (; i < end; ++i) {
+        vx_[i] = vx_[i] * damping + gravityStep.x;
+        vy_[i] = vy_[i] * damping + gravityStep.y;
+        vz_[i] = vz_[i] * damping + gravityStep.z;
+        px_[i] += vx_[i] * deltaTime;
+        py_[i] += vy_[i] * deltaTime;
+        pz_[i] += vz_[i] * deltaTime;
+        age_[i] += deltaTime;
+        const glm::vec3 position(px_[i], py_[i], pz_[i]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+
+    out.boundsMin = boundsMin;
+    out.boundsMax = boundsMax;
+}
+
+void AParticleSystem::expire() {
+    // Swap-remove touches only the expired particles; runs of four survivors are skipped with one
+    // compare. A particle moved into a hole is checked again before moving on.
+    uint32_t i = 0;
+    while (i < count_) {
+#if AP_PARTICLES_SSE
+        if (i + 4 <= count_ && _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(&age_[i]), _mm_loadu_ps(&life_[i]))) == 0xF) {
+            i += 4;
+            continue;
+        }
+#endif
+        if (age_[i] < life_[i]) {
+            ++i;
+            continue;
+        }
+        const uint32_t last = --count_;
+        px_[i] = px_[last];
+        py_[i] = py_[last];
+        pz_[i] = pz_[last];
+        vx_[i] = vx_[last];
+        vy_[i] = vy_[last];
+        vz_[i] = vz_[last];
+        age_[i] = age_[last];
+        life_[i] = life_[last];
+    }
+}
+
+void AParticleSystem::emit(uint32_t count) {
+    auto spread = [this](const glm::vec3& extent) {
+        return glm::vec3(extent.x * (2.0f * random() - 1.0f),
+                         extent.y * (2.0f * random() - 1.0f),
+                         extent.z * (2.0f * random() - 1.0f));
+    };
+    for (uint32_t n = 0; n < count; ++n) {
+        const uint32_t i = count_++;
+        const glm::vec3 position = emitter_.position + spread(emitter_.positionJitter);
+        const glm::vec3 velocity = emitter_.velocity + spread(emitter_.velocityJitter);
+        px_[i] = position.x;
+        py_[i] = position.y;
+        pz_[i] = position.z;
+        vx_[i] = velocity.x;
+        vy_[i] = velocity.y;
+        vz_[i] = velocity.z;
+        age_[i] = 0.0f;
+        life_[i] = emitter_.minLifetime + (emitter_.maxLifetime - emitter_.minLifetime) * random();
+    }
+}
+
+float AParticleSystem::random() {
+    // xorshift32; the top 24 bits map exactly onto [0, 1).
+    randomState_ ^= randomState_ << 13;
+    randomState_ ^= randomState_ >> 17;
+    randomState_ ^= randomState_ << 5;
+    return static_cast<float>(randomState_ >> 8) * (1.0f / 16777216.0f);
+}
@@ -0,0 +1,544 @@
+#include <ARenderCommandList>
+
+#include <AViewport>
+#include <AWorld>
+#include <ARenderOverlay>
+#include <AText>
+#include <AFloatingText>
+#include <ATerrain>
+#include <AParticleSystem>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+bool projectToScreen(const glm::vec3& world, const glm::mat4& viewProjection, int width, int height, glm::ivec2& out) {
+    glm::vec4 clip = viewProjection * glm::vec4(world, 1.0f);
+    if (clip.w <= 0.0f) {
+        return false;
+    }
+    glm::vec3 ndc = glm::vec3(clip) / clip.w;
+    if (ndc.z < -1.0f || ndc.z > 1.0f) {
+        return false;
+    }
+    out.x = static_cast<int>((ndc.x * 0.5f + 0.5f) * static_cast<float>(width));
+    out.y = static_cast<int>((1.0f - (ndc.y * 0.5f + 0.5f)) * static_cast<float>(height));
+    return true;
+}
+
+// Coarsest level whose error, projected at the mesh's nearest point, stays under the threshold.
+uint32_t selectLod(const AWorld::MeshData& mesh,
+                   const glm::mat4& model,
+                   const glm::mat4& view,
+                   bool perspective,
+                   float pixelsPerUnit,
+                   float thresholdPixels) {
+    if (mesh.lodCount < 2 || thresholdPixels <= 0.0f) {
+        return 0;
+    }
+    const float scale = std::max({glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))});
+    float distance = 1.0f;
+    if (perspective) {
+        const glm::vec4 center = view * (model * glm::vec4(mesh.sphereCenter, 1.0f));
+        distance = glm::length(glm::vec3(center)) - mesh.sphereRadius * scale;
+        if (distance <= 0.0f) {
+            return 0;
+        }
+    }
+    // Largest error in mesh units that still projects below the threshold.
+    const float allowed = thresholdPixels * distance / (pixelsPerUnit * scale);
+    uint32_t lod = 0;
+    while (lod + 1 < mesh.lodCount && mesh.lods[lod + 1].error <= allowed) {
+        ++lod;
+    }
+    return lod;
+}
+
+} // namespace
+
+void ARenderCommandList::clear() {
+    commands_.clear();
+    views_.clear();
+    meshes_.clear();
+    textCount_ = 0;
+    vertices_.clear();
+    vertexColors_.clear();
+    indices_.clear();
+    instances_.clear();
+    spriteBatches_.clear();
+    sprites_.clear();
+    particleDraws_.clear();
+    if (geometryKeyCount_ > 0) {
+        std::fill(geometrySlots_.begin(), geometrySlots_.end(), GeometrySlot{});
+        geometryKeyCount_ = 0;
+    }
+    worldChangeCount_ = 0;
+    culledMeshCount_ = 0;
+    triangleCount_ = 0;
+    currentView_ = 0;
+    sequence_ = 0;
+    surfaceWidth_ = 0;
+    surfaceHeight_ = 0;
+}
+
+void ARenderCommandList::build(const AViewport& viewport) {
+    clear();
+    setSurfaceSize(viewport.getX() + viewport.getWidth(), viewport.getY() + viewport.getHeight());
+    appendViewport(viewport);
+    sort();
+}
+
+void ARenderCommandList::appendViewport(const AViewport& viewport) {
+    const AViewport* single = &viewport;
+    appendViewports(std::span<const AViewport* const>(&single, 1));
+}
+
+void ARenderCommandList::appendViewports(std::span<const AViewport* const> viewports) {
+    if (visibleScratch_.size() < viewports.size()) {
+        visibleScratch_.resize(viewports.size());
+    }
+    for (size_t i = 0; i < viewports.size(); ++i) {
+        visibleScratch_[i].clear();
+    }
+
+    // Cull every viewport of a world in one call so the BVH is walked once per world, not per view.
+    for (size_t i = 0; i < viewports.size(); ++i) {
+        const AWorld* world = viewports[i]->getWorld();
+        bool seen = false;
+        for (size_t j = 0; j < i && !seen; ++j) {
+            seen = viewports[j]->getWorld() == world;
+        }
+        if (!world || seen) {
+            continue;
+        }
+
+        if (worldChanges_.size() <= worldChangeCount_) {
+            worldChanges_.resize(worldChangeCount_ + 1);
+        }
+        worldChanges_[worldChangeCount_++] = world->getChanges();
+
+        groupFrustums_.clear();
+        groupViewports_.clear();
+        for (size_t j = i; j < viewports.size(); ++j) {
+            if (viewports[j]->getWorld() == world) {
+                groupFrustums_.push_back(viewports[j]->getFrustum());
+                groupViewports_.push_back(j);
+            }
+        }
+        if (groupVisible_.size() < groupViewports_.size()) {
+            groupVisible_.resize(groupViewports_.size());
+        }
+        for (size_t g = 0; g < groupViewports_.size(); ++g) {
+            groupVisible_[g].clear();
+        }
+        world->cullEntities(groupFrustums_, std::span<std::vector<uint32_t>>(groupVisible_.data(), groupViewports_.size()));
+        for (size_t g = 0; g < groupViewports_.size(); ++g) {
+            // Swap rather than copy so both scratch lists keep their capacity.
+            std::swap(visibleScratch_[groupViewports_[g]], groupVisible_[g]);
+        }
+    }
+
+    for (size_t i = 0; i < viewports.size(); ++i) {
+        appendView(*viewports[i], visibleScratch_[i]);
+    }
+}
+
+void ARenderCommandList::appendView(const AViewport& viewport, const std::vector<uint32_t>& visible) {
+    View view;
+    view.view = viewport.getViewMatrix();
+    view.projection = viewport.getProjectionMatrix();
+    view.x = viewport.getX();
+    view.y = viewport.getY();
+    view.width = viewport.getWidth();
+    view.height = viewport.getHeight();
+    setView(view);
+
+    const AWorld* world = viewport.getWorld();
+    if (world) {
+        // Only entities that survived culling reach vertex work.
+        culledMeshCount_ += world->getEntityCount() - static_cast<uint32_t>(visible.size());
+
+        // Gather the survivors straight from the world's SoA arrays; no per-entity pointer chasing.
+        const auto worldMatrices = world->getWorldMatrices();
+        const auto colors = world->getColors();
+        const auto meshIds = world->getMeshIds();
+        const auto meshes = world->getMeshes();
+        const auto statics = world->getStaticFlags();
+
+        // Screen-space LOD: pixels covered by one world unit at distance 1 (or at any distance
+        // for orthographic projections).
+        const bool perspective = view.projection[3][3] == 0.0f;
+        const float pixelsPerUnit = 0.5f * static_cast<float>(view.height) * std::abs(view.projection[1][1]);
+        const float lodThreshold = pixelsPerUnit > 0.0f ? viewport.getLodErrorThreshold() : 0.0f;
+        static_assert(AWorld::kMaxMeshLods <= 4, "LOD index must fit the two low bits of the geometry key");
+
+        for (uint32_t i : visible) {
+            const AWorld::MeshData& mesh = meshes[meshIds[i]];
+            // Static entities are drawn by their merged batch below.
+            if (mesh.indexCount < 3 || statics[i]) {
+                continue;
+            }
+            const glm::mat4& model = worldMatrices[i];
+            const uint32_t level = selectLod(mesh, model, view.view, perspective, pixelsPerUnit, lodThreshold);
+            const AWorld::MeshGeometry geometry = world->getMeshGeometry(meshIds[i], level);
+            const glm::vec4 viewPos = view.view * model[3];
+            drawMesh(model,
+                     colors[i],
+                     geometry.vertices.data(),
+                     mesh.hasVertexColors ? geometry.vertexColors.data() : nullptr,
+                     static_cast<uint32_t>(geometry.vertices.size()),
+                     geometry.indices.data(),
+                     static_cast<uint32_t>(geometry.indices.size()),
+                     -viewPos.z,
+                     makeMeshKey(mesh.key, level));
+        }
+
+        // Static batches are already in world space with baked colors: one box test and one draw each.
+        const AFrustum& frustum = viewport.getFrustum();
+        const auto staticBatches = world->getStaticBatches();
+        for (uint32_t b = 0; b < staticBatches.size(); ++b) {
+            const AWorld::StaticBatch& batch = staticBatches[b];
+            const glm::vec3 center = (batch.boundsMin + batch.boundsMax) * 0.5f;
+            if (!frustum.intersectsAabb(center, (batch.boundsMax - batch.boundsMin) * 0.5f)) {
+                continue;
+            }
+            const AWorld::MeshGeometry geometry = world->getStaticBatchGeometry(b);
+            drawMesh(glm::mat4(1.0f),
+                     AEntity::Color{},
+                     geometry.vertices.data(),
+                     geometry.vertexColors.data(),
+                     static_cast<uint32_t>(geometry.vertices.size()),
+                     geometry.indices.data(),
+                     static_cast<uint32_t>(geometry.indices.size()),
+                     -(view.view * glm::vec4(center, 1.0f)).z,
+                     makeMeshKey(batch.key, 0));
+        }
+
+        // Instance batches: cull, pick each instance's LOD, then one command per batch and level.
+        instancesByLod_.resize(AWorld::kMaxMeshLods);
+        const auto batches = world->getInstanceBatches();
+        for (uint32_t b = 0; b < batches.size(); ++b) {
+            const AWorld::InstanceBatchData& batch = batches[b];
+            const AWorld::MeshData& mesh = meshes[batch.meshId];
+            if (!batch.alive || mesh.indexCount < 3) {
+                continue;
+            }
+            visibleInstances_.clear();
+            world->cullInstances(b, frustum, visibleInstances_);
+            culledMeshCount_ += static_cast<uint32_t>(batch.instances.size() - visibleInstances_.size());
+            if (visibleInstances_.empty()) {
+                continue;
+            }
+            for (auto& bucket : instancesByLod_) {
+                bucket.clear();
+            }
+            for (uint32_t i : visibleInstances_) {
+                const AInstance& instance = batch.instances[i];
+                const uint32_t level = selectLod(mesh, instance.transform, view.view, perspective, pixelsPerUnit, lodThreshold);
+                instancesByLod_[level].push_back(instance);
+            }
+            const glm::vec4 center(((batch.boundsMin + batch.boundsMax) * 0.5f), 1.0f);
+            const float viewDepth = -(view.view * center).z;
+            for (uint32_t level = 0; level < mesh.lodCount; ++level) {
+                if (instancesByLod_[level].empty()) {
+                    continue;
+                }
+                const AWorld::MeshGeometry geometry = world->getMeshGeometry(batch.meshId, level);
+                drawInstances(geometry.vertices.data(),
+                              mesh.hasVertexColors ? geometry.vertexColors.data() : nullptr,
+                              static_cast<uint32_t>(geometry.vertices.size()),
+                              geometry.indices.data(),
+                              static_cast<uint32_t>(geometry.indices.size()),
+                              instancesByLod_[level],
+                              viewDepth,
+                              makeMeshKey(mesh.key, level));
+            }
+        }
+
+        // Terrain: resident chunks only, each at the level its distance calls for. Morphed
+        // vertices depend on the eye, so they are never cached under a mesh key.
+        if (const ATerrain* terrain = world->getTerrain()) {
+            const glm::vec3 eye(glm::inverse(view.view)[3]);
+            const auto chunks = terrain->getChunks();
+            for (uint32_t c = 0; c < chunks.size(); ++c) {
+                const ATerrain::Chunk& chunk = chunks[c];
+                const glm::vec3 center = (chunk.boundsMin + chunk.boundsMax) * 0.5f;
+                if (!chunk.resident || !frustum.intersectsAabb(center, (chunk.boundsMax - chunk.boundsMin) * 0.5f)) {
+                    continue;
+                }
+                const uint32_t level = terrain->selectLod(c, eye);
+                terrain->buildVertices(c, level, eye, terrainVertices_, terrainColors_);
+                const auto indices = terrain->getLodIndices(level);
+                drawMesh(glm::mat4(1.0f),
+                         AEntity::Color{},
+                         terrainVertices_.data(),
+                         terrainColors_.data(),
+                         static_cast<uint32_t>(terrainVertices_.size()),
+                         indices.data(),
+                         static_cast<uint32_t>(indices.size()),
+                         -(view.view * glm::vec4(center, 1.0f)).z,
+                         0);
+            }
+        }
+
+        // Particle systems: one box test per system, then every particle becomes a sprite.
+        for (const auto& system : world->getParticleSystems()) {
+            const glm::vec3 center = (system->getBoundsMin() + system->getBoundsMax()) * 0.5f;
+            if (system->getCount() == 0 ||
+                !frustum.intersectsAabb(center, (system->getBoundsMax() - system->getBoundsMin()) * 0.5f)) {
+                continue;
+            }
+            const auto start = std::chrono::steady_clock::now();
+            const AParticleSystem::Appearance& look = system->getAppearance();
+            const auto xs = system->getPositionsX();
+            const auto ys = system->getPositionsY();
+            const auto zs = system->getPositionsZ();
+            const auto ages = system->getAges();
+            const auto lifetimes = system->getLifetimes();
+            const uint32_t first = static_cast<uint32_t>(sprites_.size());
+            sprites_.resize(first + xs.size());
+            Sprite* out = sprites_.data() + first;
+            for (size_t i = 0; i < xs.size(); ++i) {
+                const float t = std::min(ages[i] / lifetimes[i], 1.0f);
+                out[i].position = glm::vec3(xs[i], ys[i], zs[i]);
+                out[i].size = look.startSize + (look.endSize - look.startSize) * t;
+                out[i].color = AEntity::Color{look.startColor.r + (look.endColor.r - look.startColor.r) * t,
+                                              look.startColor.g + (look.endColor.g - look.startColor.g) * t,
+                                              look.startColor.b + (look.endColor.b - look.startColor.b) * t,
+                                              look.startColor.a + (look.endColor.a - look.startColor.a) * t};
+            }
+            recordSpriteBatch(first, -(view.view * glm::vec4(center, 1.0f)).z);
+            particleDraws_.push_back(ParticleDraw{
+                system.get(),
+                static_cast<uint32_t>(xs.size()),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()});
+        }
+    }
+
+    const glm::mat4 viewProjection = view.projection * view.view;
+    auto appendFloatingText = [&](const AFloatingText& text) {
+        glm::ivec2 screen{};
+        if (!projectToScreen(text.getWorldPosition(), viewProjection, view.width, view.height, screen)) {
+            return;
+        }
+        drawText(text.getText(), screen.x, screen.y, false, text.getPixelHeight(), text.getColor());
+    };
+
+    for (const auto* overlay : viewport.getOverlays()) {
+        if (!overlay) {
+            continue;
+        }
+        for (const auto& text : overlay->getTexts()) {
+            if (text) {
+                drawText(text->getText(),
+                         text->getPosition().x,
+                         text->getPosition().y,
+                         text->isAlignRight(),
+                         text->getPixelHeight(),
+                         text->getColor());
+            }
+        }
+        for (const auto& floating : overlay->getFloatingTexts()) {
+            if (floating) {
+                appendFloatingText(*floating);
+            }
+        }
+    }
+
+    if (world) {
+        for (const auto& floating : world->getFloatingTexts()) {
+            appendFloatingText(*floating);
+        }
+    }
+}
+
+uint32_t ARenderCommandList::setView(const View& view) {
+    currentView_ = static_cast<uint32_t>(views_.size());
+    views_.push_back(view);
+    commands_.push_back(Command{makeSortKey(currentView_, Layer::View, 0.0f, 0, sequence_++), Type::SetView, currentView_});
+    return currentView_;
+}
+
+void ARenderCommandList::drawMesh(const glm::mat4& model,
+                                  const AEntity::Color& color,
+                                  const glm::vec3* vertices,
+                                  const AEntity::Color* vertexColors,
+                                  uint32_t vertexCount,
+                                  const uint32_t* indices,
+                                  uint32_t indexCount,
+                                  float viewDepth,
+                                  uint64_t meshKey) {
+    Mesh mesh = recordGeometry(color, vertices, vertexColors, vertexCount, indices, indexCount, meshKey);
+    mesh.model = model;
+
+    triangleCount_ += mesh.indexCount / 3;
+    const uint32_t state = mesh.hasVertexColors ? 1u : 0u;
+    const uint32_t index = static_cast<uint32_t>(meshes_.size());
+    meshes_.push_back(mesh);
+    commands_.push_back(Command{makeSortKey(currentView_, Layer::World, viewDepth, state, sequence_++), Type::DrawMesh, index});
+}
+
+void ARenderCommandList::drawInstances(const glm::vec3* vertices,
+                                       const AEntity::Color* vertexColors,
+                                       uint32_t vertexCount,
+                                       const uint32_t* indices,
+                                       uint32_t indexCount,
+                                       std::span<const AInstance> instances,
+                                       float viewDepth,
+                                       uint64_t meshKey) {
+    if (instances.empty()) {
+        return;
+    }
+    Mesh mesh = recordGeometry(AEntity::Color{}, vertices, vertexColors, vertexCount, indices, indexCount, meshKey);
+    mesh.firstInstance = static_cast<uint32_t>(instances_.size());
+    mesh.instanceCount = static_cast<uint32_t>(instances.size());
+    instances_.insert(instances_.end(), instances.begin(), instances.end());
+
+    triangleCount_ += static_cast<uint64_t>(mesh.indexCount / 3) * mesh.instanceCount;
+    const uint32_t state = mesh.hasVertexColors ? 1u : 0u;
+    const uint32_t index = static_cast<uint32_t>(meshes_.size());
+    meshes_.push_back(mesh);
+    commands_.push_back(Command{makeSortKey(currentView_, Layer::World, viewDepth, state, sequence_++), Type::DrawInstances, index});
+}
+
+ARenderCommandList::Mesh ARenderCommandList::recordGeometry(const AEntity::Color& color,
+                                                            const glm::vec3* vertices,
+                                                            const AEntity::Color* vertexColors,
+                                                            uint32_t vertexCount,
+                                                            const uint32_t* indices,
+                                                            uint32_t indexCount,
+                                                            uint64_t meshKey) {
+    Mesh mesh;
+    mesh.color = color;
+    mesh.firstVertex = static_cast<uint32_t>(vertices_.size());
+    mesh.vertexCount = vertexCount;
+    mesh.firstIndex = static_cast<uint32_t>(indices_.size());
+    mesh.indexCount = indices ? indexCount : (vertexCount >= 3 ? (vertexCount - 2) * 3 : 0);
+    mesh.hasVertexColors = vertexColors != nullptr;
+    mesh.meshKey = meshKey;
+
+    // Geometry is copied so the list stays valid when the world changes after it was built,
+    // but only once per shared mesh.
+    bool copy = true;
+    if (meshKey != 0) {
+        bool inserted = false;
+        const GeometryRange& range = findOrAddGeometry(meshKey, GeometryRange{mesh.firstVertex, mesh.firstIndex}, inserted);
+        mesh.firstVertex = range.firstVertex;
+        mesh.firstIndex = range.firstIndex;
+        copy = inserted;
+    }
+    if (copy) {
+        if (indices) {
+            indices_.insert(indices_.end(), indices, indices + indexCount);
+        } else {
+            for (uint32_t i = 1; i + 1 < vertexCount; ++i) {
+                indices_.insert(indices_.end(), {0u, i, i + 1});
+            }
+        }
+        vertices_.insert(vertices_.end(), vertices, vertices + vertexCount);
+        if (vertexColors) {
+            vertexColors_.insert(vertexColors_.end(), vertexColors, vertexColors + vertexCount);
+        } else {
+            vertexColors_.insert(vertexColors_.end(), vertexCount, color);
+        }
+    }
+    return mesh;
+}
+
+const ARenderCommandList::GeometryRange& ARenderCommandList::findOrAddGeometry(uint64_t meshKey,
+                                                                               const GeometryRange& range,
+                                                                               bool& inserted) {
+    // Keep the table at most half full.
+    if (2 * (static_cast<size_t>(geometryKeyCount_) + 1) > geometrySlots_.size()) {
+        std::vector<GeometrySlot> old(std::max<size_t>(64, geometrySlots_.size() * 2));
+        old.swap(geometrySlots_);
+        geometryKeyCount_ = 0;
+        for (const GeometrySlot& slot : old) {
+            if (slot.key != 0) {
+                bool reinserted = false;
+                findOrAddGeometry(slot.key, slot.range, reinserted);
+            }
+        }
+    }
+
+    const size_t mask = geometrySlots_.size() - 1;
+    size_t i = static_cast<size_t>((meshKey * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (geometrySlots_[i].key != 0 && geometrySlots_[i].key != meshKey) {
+        i = (i + 1) & mask;
+    }
+    GeometrySlot& slot = geometrySlots_[i];
+    inserted = slot.key == 0;
+    if (inserted) {
+        slot.key = meshKey;
+        slot.range = range;
+        ++geometryKeyCount_;
+    }
+    return slot.range;
+}
+
+void ARenderCommandList::drawSprites(std::span<const Sprite> sprites, float viewDepth) {
+    const uint32_t first = static_cast<uint32_t>(sprites_.size());
+    sprites_.insert(sprites_.end(), sprites.begin(), sprites.end());
+    recordSpriteBatch(first, viewDepth);
+}
+
+void ARenderCommandList::recordSpriteBatch(uint32_t firstSprite, float viewDepth) {
+    const uint32_t count = static_cast<uint32_t>(sprites_.size()) - firstSprite;
+    if (count == 0) {
+        return;
+    }
+    triangleCount_ += 2ull * count;
+    const uint32_t index = static_cast<uint32_t>(spriteBatches_.size());
+    spriteBatches_.push_back(SpriteBatch{firstSprite, count});
+    // State 2 draws sprite batches after every mesh of the view.
+    commands_.push_back(Command{makeSortKey(currentView_, Layer::World, viewDepth, 2, sequence_++), Type::DrawSprites, index});
+}
+
+void ARenderCommandList::drawText(const Text& text) {
+    drawText(text.text, text.x, text.y, text.alignRight, text.pixelHeight, text.color);
+}
+
+void ARenderCommandList::drawText(std::string_view text, int x, int y, bool alignRight, int pixelHeight, const AEntity::Color& color) {
+    const uint32_t index = textCount_++;
+    if (index == texts_.size()) {
+        texts_.emplace_back();
+    }
+    // Assigning into a reused slot keeps its capacity, so steady frames copy text without allocating.
+    Text& slot = texts_[index];
+    slot.text.assign(text);
+    slot.x = x;
+    slot.y = y;
+    slot.alignRight = alignRight;
+    slot.pixelHeight = pixelHeight;
+    slot.color = color;
+    // Overlay text keeps submission order so later texts draw on top.
+    commands_.push_back(Command{makeSortKey(currentView_, Layer::Overlay, 0.0f, 0, sequence_++), Type::DrawText, index});
+}
+
+void ARenderCommandList::sort() {
+    std::sort(commands_.begin(), commands_.end(), [](const Command& a, const Command& b) {
+        return a.sortKey < b.sortKey;
+    });
+}
+
+void ARenderCommandList::setSurfaceSize(int width, int height) {
+    surfaceWidth_ = width;
+    surfaceHeight_ = height;
+}
+
+uint64_t ARenderCommandList::makeSortKey(uint32_t viewIndex, Layer layer, float viewDepth, uint32_t state, uint32_t sequence) {
+    // Positive IEEE floats order like their bit patterns, so the top 24 bits give a front-to-back
+    // depth key without knowing the clip range. Geometry behind the camera collapses to zero.
+    uint32_t depthBits = 0;
+    if (viewDepth > 0.0f) {
+        std::memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+        depthBits >>= 8;
+    }
+    return (static_cast<uint64_t>(viewIndex & 0xFFu) << 56) |
+           (static_cast<uint64_t>(static_cast<uint8_t>(layer) & 0x3u) << 54) |
+           (static_cast<uint64_t>(state & 0x3Fu) << 48) |
+           (static_cast<uint64_t>(depthBits & 0xFFFFFFu) << 24) |
+           static_cast<uint64_t>(sequence & 0xFFFFFFu);
+}
@@ -1,27 +1,52 @@
 #include <ARenderOverlay>
 
+#include <algorithm>
+
+namespace {
+
+template <typename Pointer, typename T>
+bool swapAndPop(std::vector<Pointer>& list, const T* object) {
+    auto it = std::find_if(list.begin(), list.end(), [object](const auto& owned) { return owned.get() == object; });
+    if (it == list.end()) {
+        return false;
+    }
+    std::swap(*it, list.back());
+    list.pop_back(); // The pointer's deleter returns the text to its pool.
+    return true;
+}
+
+} // namespace
+
 AText& ARenderOverlay::addText(const AText& text) {
-    texts_.push_back(std::make_unique<AText>(text));
+    texts_.push_back(textPool_.make(text));
     return *texts_.back();
 }
 
 AFloatingText& ARenderOverlay::addFloatingText(const AFloatingText& text) {
-    floatingTexts_.push_back(std::make_unique<AFloatingText>(text));
+    floatingTexts_.push_back(floatingTextPool_.make(text));
     return *floatingTexts_.back();
 }
 
-std::vector<std::unique_ptr<AText>>& ARenderOverlay::getTexts() {
+bool ARenderOverlay::removeText(const AText* text) {
+    return swapAndPop(texts_, text);
+}
+
+bool ARenderOverlay::removeFloatingText(const AFloatingText* text) {
+    return swapAndPop(floatingTexts_, text);
+}
+
+std::vector<ARenderOverlay::TextPointer>& ARenderOverlay::getTexts() {
     return texts_;
 }
 
-const std::vector<std::unique_ptr<AText>>& ARenderOverlay::getTexts() const {
+const std::vector<ARenderOverlay::TextPointer>& ARenderOverlay::getTexts() const {
     return texts_;
 }
 
-std::vector<std::unique_ptr<AFloatingText>>& ARenderOverlay::getFloatingTexts() {
+std::vector<ARenderOverlay::FloatingTextPointer>& ARenderOverlay::getFloatingTexts() {
     return floatingTexts_;
 }
 
-const std::vector<std::unique_ptr<AFloatingText>>& ARenderOverlay::getFloatingTexts() const {
+const std::vector<ARenderOverlay::FloatingTextPointer>& ARenderOverlay::getFloatingTexts() const {
     return floatingTexts_;
 }
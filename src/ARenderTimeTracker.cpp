@@ -11,6 +11,7 @@ const char* backendName(EGraphicsBackend backend) {
     case EGraphicsBackend::Vulkan: return "Vulkan";
     case EGraphicsBackend::DirectX11: return "DX11";
     case EGraphicsBackend::DirectX12: return "DX12";
+    case EGraphicsBackend::Headless: return "Headless";
     default: return "None";
     }
 }
@@ -27,12 +28,27 @@ void ARenderTimeTracker::trackDraw(AWindow& window) {
 }
 
 void ARenderTimeTracker::timeDraw(AWindow& window) {
+    timeWindow(window, [&window] { window.display(); });
+}
+
+void ARenderTimeTracker::timePresent(AWindow& window, const ARenderCommandList& commands) {
+    timeWindow(window, [&window, &commands] { window.presentFrame(commands); });
+}
+
+template <typename DrawFn>
+void ARenderTimeTracker::timeWindow(AWindow& window, DrawFn&& draw) {
     const EGraphicsBackend backend = window.getGraphicsBackend();
     const auto start = std::chrono::steady_clock::now();
-    window.display();
+    draw();
     const auto end = std::chrono::steady_clock::now();
     const double elapsedMs =
         std::chrono::duration<double, std::milli>(end - start).count();
+
+    // GPU results lag a few frames behind; record them first so the CPU sample can trigger the report.
+    double gpuMs = 0.0;
+    if (window.getGpuTime(gpuMs)) {
+        recordGpu(backend, gpuMs);
+    }
     record(backend, elapsedMs);
 }
 
@@ -52,6 +68,23 @@ void ARenderTimeTracker::record(EGraphicsBackend backend, double elapsedMillisec
     }
 }
 
+void ARenderTimeTracker::recordGpu(EGraphicsBackend backend, double elapsedMilliseconds) {
+    if (backend == EGraphicsBackend::None) {
+        return;
+    }
+
+    const size_t idx = static_cast<size_t>(backend);
+    m_stats[idx].gpuAccumulatedMs += elapsedMilliseconds;
+    m_stats[idx].gpuSamples++;
+}
+
+void ARenderTimeTracker::recordSwitch(const AWindow& window) {
+    std::printf("[Backend switch] %s: %.3f ms (%s)\n",
+                backendName(window.getGraphicsBackend()),
+                window.getLastBackendSwitchMilliseconds(),
+                window.wasLastBackendSwitchWarm() ? "warm" : "cold");
+}
+
 void ARenderTimeTracker::reportAndReset() {
     double totalMs = 0.0;
     for (const auto& stat : m_stats) {
@@ -62,7 +95,7 @@ void ARenderTimeTracker::reportAndReset() {
         return;
     }
 
-    std::printf("[Render CPU] ");
+    std::printf("[Render CPU/GPU] ");
     bool first = true;
     for (size_t i = 0; i < m_stats.size(); ++i) {
         const auto& stat = m_stats[i];
@@ -71,11 +104,16 @@ void ARenderTimeTracker::reportAndReset() {
         }
         const double percent = (stat.accumulatedMs / totalMs) * 100.0;
         const double averageMs = stat.accumulatedMs / static_cast<double>(stat.samples);
-        std::printf("%s%s: %.1f%% (avg %.3f ms)",
+        std::printf("%s%s: %.1f%% (cpu %.3f ms",
                     first ? "" : " | ",
                     backendName(static_cast<EGraphicsBackend>(i)),
                     percent,
                     averageMs);
+        if (stat.gpuSamples > 0) {
+            std::printf(", gpu %.3f ms)", stat.gpuAccumulatedMs / static_cast<double>(stat.gpuSamples));
+        } else {
+            std::printf(", gpu n/a)");
+        }
         first = false;
     }
     std::printf("\n");
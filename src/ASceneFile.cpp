@@ -0,0 +1,285 @@
+#include <ASceneFile>
+
+#include <AWorld>
+#include <AFloatingText>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+static_assert(sizeof(glm::vec3) == 12 && sizeof(glm::vec4) == 16, "Mapped vectors must be tightly packed floats");
+static_assert(sizeof(AEntity::Color) == 16, "Mapped colors must be four floats");
+
+constexpr uint32_t kElementSizes[] = {
+    sizeof(glm::vec3),                 // Vertices
+    sizeof(AEntity::Color),            // VertexColors
+    sizeof(uint32_t),                  // Indices
+    sizeof(ASceneFile::MeshRecord),    // Meshes
+    sizeof(glm::vec3),                 // EntityPositions
+    sizeof(glm::vec4),                 // EntityRotations
+    sizeof(glm::vec3),                 // EntityScales
+    sizeof(AEntity::Color),            // EntityColors
+    sizeof(uint32_t),                  // EntityMeshes
+    sizeof(uint32_t),                  // EntityParents
+    sizeof(ASceneFile::TextRecord),    // Texts
+    1,                                 // Strings
+};
+static_assert(std::size(kElementSizes) == static_cast<size_t>(ASceneFile::SectionType::Count));
+
+uint64_t alignUp(uint64_t value) {
+    return (value + ASceneFile::kAlignment - 1) & ~static_cast<uint64_t>(ASceneFile::kAlignment - 1);
+}
+
+} // namespace
+
+ASceneFile::~ASceneFile() {
+    close();
+}
+
+bool ASceneFile::open(const std::string& path) {
+    close();
+    if constexpr (std::endian::native != std::endian::little) {
+        return false; // The format is little-endian and used in place, so there is nothing to swap into.
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced.
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = static_cast<uint64_t>(info.st_size);
+#endif
+
+    Header header;
+    std::memcpy(&header, data_, sizeof(header));
+    const uint64_t tableEnd = sizeof(Header) + static_cast<uint64_t>(header.sectionCount) * sizeof(Section);
+    if (header.magic != kMagic || header.version != kVersion || header.fileSize != size_ || tableEnd > size_) {
+        close();
+        return false;
+    }
+
+    sections_ = {};
+    const auto* table = reinterpret_cast<const Section*>(data_ + sizeof(Header));
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        const Section& section = table[i];
+        const auto type = static_cast<size_t>(section.type);
+        // Unknown section types are skipped so later minor additions stay readable.
+        if (type >= sections_.size()) {
+            continue;
+        }
+        const uint64_t bytes = section.count * section.elementSize;
+        const bool valid = section.elementSize == kElementSizes[type] &&
+                           section.offset % kAlignment == 0 && section.offset >= tableEnd &&
+                           (section.count == 0 || bytes / section.count == section.elementSize) &&
+                           section.offset <= size_ && bytes <= size_ - section.offset;
+        if (!valid) {
+            close();
+            return false;
+        }
+        sections_[type] = section;
+    }
+    return true;
+}
+
+void ASceneFile::close() {
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(static_cast<HANDLE>(mapping_));
+    }
+    if (file_) {
+        CloseHandle(static_cast<HANDLE>(file_));
+    }
+#else
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    file_ = nullptr;
+    mapping_ = nullptr;
+    sections_ = {};
+}
+
+std::string_view ASceneFile::getText(const TextRecord& text) const {
+    const auto strings = section<char>(SectionType::Strings);
+    if (text.textOffset > strings.size() || text.textLength > strings.size() - text.textOffset) {
+        return {};
+    }
+    return std::string_view(strings.data() + text.textOffset, text.textLength);
+}
+
+bool ASceneFile::write(const std::string& path, const AWorld& world) {
+    if constexpr (std::endian::native != std::endian::little) {
+        return false;
+    }
+
+    // Only meshes some entity uses are written, renumbered in first-use order.
+    const auto meshes = world.getMeshes();
+    const auto entityMeshIds = world.getMeshIds();
+    std::vector<uint32_t> fileMeshIndex(meshes.size(), kNoParent);
+    std::vector<MeshRecord> meshRecords;
+    std::vector<glm::vec3> vertices;
+    std::vector<AEntity::Color> vertexColors;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> entityMeshes(entityMeshIds.size());
+    for (size_t i = 0; i < entityMeshIds.size(); ++i) {
+        const uint32_t meshId = entityMeshIds[i];
+        if (fileMeshIndex[meshId] == kNoParent) {
+            const AWorld::MeshData& mesh = meshes[meshId];
+            MeshRecord record;
+            record.hash = mesh.hash;
+            record.lodCount = mesh.lodCount;
+            record.hasVertexColors = mesh.hasVertexColors ? 1u : 0u;
+            std::memcpy(record.boundsMin, &mesh.boundsMin, sizeof(record.boundsMin));
+            std::memcpy(record.boundsMax, &mesh.boundsMax, sizeof(record.boundsMax));
+            std::memcpy(record.sphereCenter, &mesh.sphereCenter, sizeof(record.sphereCenter));
+            record.sphereRadius = mesh.sphereRadius;
+            for (uint32_t level = 0; level < mesh.lodCount; ++level) {
+                const AWorld::MeshGeometry geometry = world.getMeshGeometry(meshId, level);
+                LodRecord& lod = record.lods[level];
+                lod.firstVertex = static_cast<uint32_t>(vertices.size());
+                lod.vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+                lod.firstIndex = static_cast<uint32_t>(indices.size());
+                lod.indexCount = static_cast<uint32_t>(geometry.indices.size());
+                lod.error = mesh.lods[level].error;
+                vertices.insert(vertices.end(), geometry.vertices.begin(), geometry.vertices.end());
+                // Colors stay parallel to vertices; uncolored meshes pad with the default.
+                if (geometry.vertexColors.empty()) {
+                    vertexColors.resize(vertices.size());
+                } else {
+                    vertexColors.insert(vertexColors.end(), geometry.vertexColors.begin(), geometry.vertexColors.end());
+                }
+                indices.insert(indices.end(), geometry.indices.begin(), geometry.indices.end());
+            }
+            fileMeshIndex[meshId] = static_cast<uint32_t>(meshRecords.size());
+            meshRecords.push_back(record);
+        }
+        entityMeshes[i] = fileMeshIndex[meshId];
+    }
+
+    const uint32_t entityCount = world.getEntityCount();
+    std::vector<glm::vec4> rotations(entityCount);
+    std::vector<uint32_t> parents(entityCount);
+    for (uint32_t i = 0; i < entityCount; ++i) {
+        const glm::quat& q = world.getRotations()[i];
+        rotations[i] = glm::vec4(q.x, q.y, q.z, q.w);
+        const uint32_t parent = world.getParentIndex(i);
+        parents[i] = parent == AWorld::kNoParent ? kNoParent : parent;
+    }
+
+    std::vector<TextRecord> texts;
+    std::string strings;
+    for (const auto& text : world.getFloatingTexts()) {
+        TextRecord record;
+        std::memcpy(record.position, &text->getWorldPosition(), sizeof(record.position));
+        record.pixelHeight = text->getPixelHeight();
+        std::memcpy(record.color, &text->getColor(), sizeof(record.color));
+        record.textOffset = static_cast<uint32_t>(strings.size());
+        record.textLength = static_cast<uint32_t>(text->getText().size());
+        strings += text->getText();
+        texts.push_back(record);
+    }
+
+    struct Payload {
+        SectionType type;
+        const void* data;
+        uint64_t count;
+    };
+    const Payload payloads[] = {
+        {SectionType::Vertices, vertices.data(), vertices.size()},
+        {SectionType::VertexColors, vertexColors.data(), vertexColors.size()},
+        {SectionType::Indices, indices.data(), indices.size()},
+        {SectionType::Meshes, meshRecords.data(), meshRecords.size()},
+        {SectionType::EntityPositions, world.getPositions().data(), entityCount},
+        {SectionType::EntityRotations, rotations.data(), entityCount},
+        {SectionType::EntityScales, world.getScales().data(), entityCount},
+        {SectionType::EntityColors, world.getColors().data(), entityCount},
+        {SectionType::EntityMeshes, entityMeshes.data(), entityCount},
+        {SectionType::EntityParents, parents.data(), entityCount},
+        {SectionType::Texts, texts.data(), texts.size()},
+        {SectionType::Strings, strings.data(), strings.size()},
+    };
+
+    Header header;
+    header.sectionCount = static_cast<uint32_t>(std::size(payloads));
+    std::vector<Section> table;
+    uint64_t offset = alignUp(sizeof(Header) + std::size(payloads) * sizeof(Section));
+    for (const Payload& payload : payloads) {
+        const uint32_t elementSize = kElementSizes[static_cast<size_t>(payload.type)];
+        table.push_back(Section{payload.type, elementSize, offset, payload.count});
+        offset = alignUp(offset + payload.count * elementSize);
+    }
+    header.fileSize = offset;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(Section)));
+    static const char padding[kAlignment] = {};
+    uint64_t written = sizeof(header) + table.size() * sizeof(Section);
+    for (size_t i = 0; i < table.size(); ++i) {
+        out.write(padding, static_cast<std::streamsize>(table[i].offset - written));
+        const uint64_t bytes = table[i].count * table[i].elementSize;
+        out.write(static_cast<const char*>(payloads[i].data), static_cast<std::streamsize>(bytes));
+        written = table[i].offset + bytes;
+    }
+    out.write(padding, static_cast<std::streamsize>(header.fileSize - written));
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,335 @@
+#include <ASpatialHash>
+#include <AWorkerPool>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+
+namespace {
+
+// Fewer items than this per thread are hashed on the calling thread alone.
+constexpr size_t kMinItemsPerThread = 16384;
+constexpr uint32_t kMinBuckets = 64;
+constexpr float kMaxCellCoordinate = 1073741824.0f; // 2^30, keeps cell math inside int32.
+
+bool cellInRange(const glm::ivec3& cell, const glm::ivec3& lo, const glm::ivec3& hi) {
+    return cell.x >= lo.x && cell.y >= lo.y && cell.z >= lo.z && cell.x <= hi.x && cell.y <= hi.y && cell.z <= hi.z;
+}
+
+} // namespace
+
+ASpatialHash::ASpatialHash(float cellSize) {
+    setCellSize(cellSize);
+}
+
+void ASpatialHash::setCellSize(float cellSize) {
+    cellSize_ = std::max(cellSize, 1e-6f);
+    inverseCellSize_ = 1.0f / cellSize_;
+    if (itemCount_ == 0) {
+        return;
+    }
+    std::fill(heads_.begin(), heads_.end(), kNone);
+    occupiedMin_ = glm::ivec3(std::numeric_limits<int>::max());
+    occupiedMax_ = glm::ivec3(std::numeric_limits<int>::min());
+    for (uint32_t id = 0; id < items_.size(); ++id) {
+        Item& item = items_[id];
+        if (item.bucket == kNone) {
+            continue;
+        }
+        item.cell = cellOf(item.position);
+        item.bucket = bucketOf(item.cell);
+        link(id);
+        occupiedMin_ = glm::min(occupiedMin_, item.cell);
+        occupiedMax_ = glm::max(occupiedMax_, item.cell);
+    }
+}
+
+void ASpatialHash::clear() {
+    items_.clear();
+    std::fill(heads_.begin(), heads_.end(), kNone);
+    itemCount_ = 0;
+    occupiedMin_ = glm::ivec3(0);
+    occupiedMax_ = glm::ivec3(-1);
+}
+
+bool ASpatialHash::contains(uint32_t id) const {
+    return id < items_.size() && items_[id].bucket != kNone;
+}
+
+void ASpatialHash::update(uint32_t id, const glm::vec3& position) {
+    if (id >= items_.size()) {
+        items_.resize(static_cast<size_t>(id) + 1);
+    }
+    const glm::ivec3 cell = cellOf(position);
+    if (itemCount_ == 0) {
+        occupiedMin_ = cell;
+        occupiedMax_ = cell;
+    }
+    occupiedMin_ = glm::min(occupiedMin_, cell);
+    occupiedMax_ = glm::max(occupiedMax_, cell);
+
+    if (items_[id].bucket == kNone) {
+        // Keep at least two buckets per item so lists stay short.
+        if (2 * (static_cast<size_t>(itemCount_) + 1) > heads_.size()) {
+            rehash(itemCount_ + 1);
+        }
+        Item& item = items_[id];
+        item.position = position;
+        item.cell = cell;
+        item.bucket = bucketOf(cell);
+        link(id);
+        ++itemCount_;
+        return;
+    }
+
+    Item& item = items_[id];
+    item.position = position;
+    if (cell == item.cell) {
+        return;
+    }
+    item.cell = cell;
+    const uint32_t bucket = bucketOf(cell);
+    if (bucket != item.bucket) {
+        unlink(id);
+        item.bucket = bucket;
+        link(id);
+    }
+}
+
+void ASpatialHash::remove(uint32_t id) {
+    if (!contains(id)) {
+        return;
+    }
+    unlink(id);
+    items_[id].bucket = kNone;
+    --itemCount_;
+}
+
+void ASpatialHash::rebuild(std::span<const uint32_t> ids, std::span<const glm::vec3> positions) {
+    const size_t count = std::min(ids.size(), positions.size());
+    uint32_t maxId = 0;
+    for (size_t k = 0; k < count; ++k) {
+        maxId = std::max(maxId, ids[k]);
+    }
+    items_.assign(count > 0 ? static_cast<size_t>(maxId) + 1 : 0, Item{});
+    heads_.assign(std::max<size_t>(kMinBuckets, std::bit_ceil(2 * std::max<size_t>(count, 1))), kNone);
+    bucketMask_ = static_cast<uint32_t>(heads_.size() - 1);
+    itemCount_ = static_cast<uint32_t>(count);
+
+    // Every thread prepends its items to the bucket lists with an atomic exchange on the head;
+    // ids are unique, so each item is written by one thread only.
+    AWorkerPool& pool = AWorkerPool::shared();
+    const size_t chunks = std::clamp<size_t>(count / kMinItemsPerThread, 1, pool.getThreadCount());
+    chunkBounds_.resize(chunks);
+    pool.parallelFor(count, chunks, [&](size_t chunk, size_t begin, size_t end) {
+        glm::ivec3 cellMin(std::numeric_limits<int>::max());
+        glm::ivec3 cellMax(std::numeric_limits<int>::min());
+        for (size_t k = begin; k < end; ++k) {
+            const uint32_t id = ids[k];
+            Item& item = items_[id];
+            item.position = positions[k];
+            item.cell = cellOf(item.position);
+            item.bucket = bucketOf(item.cell);
+            item.next = std::atomic_ref<uint32_t>(heads_[item.bucket]).exchange(id, std::memory_order_relaxed);
+            cellMin = glm::min(cellMin, item.cell);
+            cellMax = glm::max(cellMax, item.cell);
+        }
+        chunkBounds_[chunk] = {cellMin, cellMax};
+    });
+    // Each item has exactly one predecessor, so back links can be filled in parallel too.
+    pool.parallelFor(count, chunks, [&](size_t, size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            const uint32_t next = items_[ids[k]].next;
+            if (next != kNone) {
+                items_[next].prev = ids[k];
+            }
+        }
+    });
+
+    occupiedMin_ = glm::ivec3(0);
+    occupiedMax_ = glm::ivec3(-1);
+    if (count > 0) {
+        occupiedMin_ = chunkBounds_[0].first;
+        occupiedMax_ = chunkBounds_[0].second;
+        for (size_t chunk = 1; chunk < chunks; ++chunk) {
+            occupiedMin_ = glm::min(occupiedMin_, chunkBounds_[chunk].first);
+            occupiedMax_ = glm::max(occupiedMax_, chunkBounds_[chunk].second);
+        }
+    }
+}
+
+template <typename Visit>
+void ASpatialHash::forEachInCells(const glm::ivec3& minCell, const glm::ivec3& maxCell, Visit&& visit) const {
+    if (itemCount_ == 0) {
+        return;
+    }
+    const glm::ivec3 lo = glm::max(minCell, occupiedMin_);
+    const glm::ivec3 hi = glm::min(maxCell, occupiedMax_);
+    if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z) {
+        return;
+    }
+    const glm::ivec3 extent = hi - lo + glm::ivec3(1);
+    const uint64_t cellCount = static_cast<uint64_t>(extent.x) * static_cast<uint64_t>(extent.y) * static_cast<uint64_t>(extent.z);
+    if (cellCount > itemCount_) {
+        for (uint32_t id = 0; id < items_.size(); ++id) {
+            const Item& item = items_[id];
+            if (item.bucket != kNone && cellInRange(item.cell, lo, hi)) {
+                visit(id);
+            }
+        }
+        return;
+    }
+    for (int z = lo.z; z <= hi.z; ++z) {
+        for (int y = lo.y; y <= hi.y; ++y) {
+            for (int x = lo.x; x <= hi.x; ++x) {
+                const glm::ivec3 cell(x, y, z);
+                for (uint32_t id = heads_[bucketOf(cell)]; id != kNone; id = items_[id].next) {
+                    if (items_[id].cell == cell) {
+                        visit(id);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ASpatialHash::queryRadius(const glm::vec3& center, float radius, std::vector<uint32_t>& outIds) const {
+    const float radius2 = radius * radius;
+    forEachInCells(cellOf(center - glm::vec3(radius)), cellOf(center + glm::vec3(radius)), [&](uint32_t id) {
+        const glm::vec3 d = items_[id].position - center;
+        if (glm::dot(d, d) <= radius2) {
+            outIds.push_back(id);
+        }
+    });
+}
+
+void ASpatialHash::queryAabb(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& outIds) const {
+    forEachInCells(cellOf(min), cellOf(max), [&](uint32_t id) {
+        const glm::vec3& p = items_[id].position;
+        if (p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y && p.z >= min.z && p.z <= max.z) {
+            outIds.push_back(id);
+        }
+    });
+}
+
+void ASpatialHash::queryNearest(const glm::vec3& point, uint32_t k, std::vector<uint32_t>& outIds, float maxDistance) const {
+    if (k == 0 || itemCount_ == 0) {
+        return;
+    }
+    const float maxDistance2 = maxDistance * maxDistance;
+    // Max-heap of the best k so far, by squared distance.
+    std::vector<std::pair<float, uint32_t>>& best = nearestScratch_;
+    best.clear();
+    auto consider = [&](uint32_t id) {
+        const glm::vec3 d = items_[id].position - point;
+        const float distance2 = glm::dot(d, d);
+        if (distance2 > maxDistance2) {
+            return;
+        }
+        if (best.size() < k) {
+            best.emplace_back(distance2, id);
+            std::push_heap(best.begin(), best.end());
+        } else if (distance2 < best.front().first) {
+            std::pop_heap(best.begin(), best.end());
+            best.back() = {distance2, id};
+            std::push_heap(best.begin(), best.end());
+        }
+    };
+
+    // Search shells of cells around the point's cell outward. Everything in shell r is at least
+    // (r - 1) cells away, which ends the search once the k-th best is closer than that.
+    const glm::ivec3 center = cellOf(point);
+    const glm::ivec3 reach = glm::max(center - occupiedMin_, occupiedMax_ - center);
+    const int lastShell = std::max({reach.x, reach.y, reach.z, 0});
+    size_t cellsVisited = 0;
+    for (int r = 0; r <= lastShell; ++r) {
+        const float shellDistance = static_cast<float>(std::max(r - 1, 0)) * cellSize_;
+        if (shellDistance > maxDistance || (best.size() == k && best.front().first <= shellDistance * shellDistance)) {
+            break;
+        }
+        // Sparse neighbourhoods: once the shells cost more than the items, test the items directly.
+        const size_t side = 2 * static_cast<size_t>(r) + 1;
+        cellsVisited += side * side * side;
+        if (cellsVisited > 2 * static_cast<size_t>(itemCount_)) {
+            best.clear();
+            for (uint32_t id = 0; id < items_.size(); ++id) {
+                if (items_[id].bucket != kNone) {
+                    consider(id);
+                }
+            }
+            break;
+        }
+        for (int dz = -r; dz <= r; ++dz) {
+            for (int dy = -r; dy <= r; ++dy) {
+                // Inner rows of the shell only have their two end cells on the surface.
+                const bool fullRow = dz == -r || dz == r || dy == -r || dy == r;
+                const int step = fullRow || r == 0 ? 1 : 2 * r;
+                for (int dx = -r; dx <= r; dx += step) {
+                    const glm::ivec3 cell = center + glm::ivec3(dx, dy, dz);
+                    if (!cellInRange(cell, occupiedMin_, occupiedMax_)) {
+                        continue;
+                    }
+                    for (uint32_t id = heads_[bucketOf(cell)]; id != kNone; id = items_[id].next) {
+                        if (items_[id].cell == cell) {
+                            consider(id);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end());
+    for (const auto& [distance2, id] : best) {
+        outIds.push_back(id);
+    }
+}
+
+glm::ivec3 ASpatialHash::cellOf(const glm::vec3& position) const {
+    auto axis = [this](float value) {
+        return static_cast<int>(std::clamp(std::floor(value * inverseCellSize_), -kMaxCellCoordinate, kMaxCellCoordinate));
+    };
+    return glm::ivec3(axis(position.x), axis(position.y), axis(position.z));
+}
+
+uint32_t ASpatialHash::bucketOf(const glm::ivec3& cell) const {
+    uint32_t hash = static_cast<uint32_t>(cell.x) * 73856093u ^ static_cast<uint32_t>(cell.y) * 19349663u ^
+                    static_cast<uint32_t>(cell.z) * 83492791u;
+    hash ^= hash >> 16;
+    return hash & bucketMask_;
+}
+
+void ASpatialHash::link(uint32_t id) {
+    Item& item = items_[id];
+    item.prev = kNone;
+    item.next = heads_[item.bucket];
+    if (item.next != kNone) {
+        items_[item.next].prev = id;
+    }
+    heads_[item.bucket] = id;
+}
+
+void ASpatialHash::unlink(uint32_t id) {
+    const Item& item = items_[id];
+    if (item.prev != kNone) {
+        items_[item.prev].next = item.next;
+    } else {
+        heads_[item.bucket] = item.next;
+    }
+    if (item.next != kNone) {
+        items_[item.next].prev = item.prev;
+    }
+}
+
+void ASpatialHash::rehash(uint32_t itemCount) {
+    const size_t bucketCount = std::max<size_t>(kMinBuckets, std::bit_ceil(2 * static_cast<size_t>(itemCount)));
+    heads_.assign(bucketCount, kNone);
+    bucketMask_ = static_cast<uint32_t>(bucketCount - 1);
+    for (uint32_t id = 0; id < items_.size(); ++id) {
+        if (items_[id].bucket != kNone) {
+            items_[id].bucket = bucketOf(items_[id].cell);
+            link(id);
+        }
+    }
+}
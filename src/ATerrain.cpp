@@ -0,0 +1,408 @@
+#include <ATerrain>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace {
+
+// Share of a level's range over which its vertices morph toward the next coarser level.
+constexpr float kMorphStart = 0.7f;
+constexpr uint32_t kMaxChunkCells = 1024;
+constexpr uint32_t kNoChunk = 0xFFFFFFFFu;
+
+// Grid index of the k-th vertex walking around the border of an n x n grid.
+uint32_t borderVertex(uint32_t n, uint32_t k) {
+    const uint32_t side = n - 1;
+    if (k < side) {
+        return k; // Bottom row, left to right.
+    }
+    k -= side;
+    if (k < side) {
+        return k * n + side; // Right column, upward.
+    }
+    k -= side;
+    if (k < side) {
+        return side * n + (side - k); // Top row, right to left.
+    }
+    k -= side;
+    return (side - k) * n; // Left column, downward.
+}
+
+AEntity::Color heightColor(float t) {
+    // Grass, then rock, then snow.
+    const glm::vec3 grass(0.24f, 0.42f, 0.18f);
+    const glm::vec3 rock(0.45f, 0.38f, 0.30f);
+    const glm::vec3 snow(0.92f, 0.92f, 0.95f);
+    const glm::vec3 c = t < 0.6f ? glm::mix(grass, rock, t / 0.6f) : glm::mix(rock, snow, (t - 0.6f) / 0.4f);
+    return AEntity::Color{c.x, c.y, c.z, 1.0f};
+}
+
+} // namespace
+
+bool ATerrain::write(const std::string& path,
+                     std::span<const float> heights,
+                     uint32_t samplesX,
+                     uint32_t samplesY,
+                     uint32_t chunkCells,
+                     float cellSize) {
+    if (chunkCells == 0 || chunkCells > kMaxChunkCells || !std::has_single_bit(chunkCells) ||
+        samplesX < 2 || samplesY < 2 || (samplesX - 1) % chunkCells != 0 || (samplesY - 1) % chunkCells != 0 ||
+        heights.size() != static_cast<size_t>(samplesX) * samplesY) {
+        return false;
+    }
+
+    Header header;
+    header.chunksX = (samplesX - 1) / chunkCells;
+    header.chunksY = (samplesY - 1) / chunkCells;
+    header.chunkCells = chunkCells;
+    header.cellSize = cellSize;
+    const uint32_t samples = chunkCells + 1;
+    const uint32_t chunkCount = header.chunksX * header.chunksY;
+
+    std::vector<ChunkRecord> records(chunkCount);
+    std::vector<float> data(static_cast<size_t>(chunkCount) * samples * samples);
+    uint64_t offset = sizeof(Header) + sizeof(ChunkRecord) * static_cast<uint64_t>(chunkCount);
+    for (uint32_t cy = 0; cy < header.chunksY; ++cy) {
+        for (uint32_t cx = 0; cx < header.chunksX; ++cx) {
+            const uint32_t chunk = cy * header.chunksX + cx;
+            float* out = data.data() + static_cast<size_t>(chunk) * samples * samples;
+            ChunkRecord& record = records[chunk];
+            record.offset = offset;
+            record.minHeight = std::numeric_limits<float>::max();
+            record.maxHeight = -std::numeric_limits<float>::max();
+            for (uint32_t y = 0; y < samples; ++y) {
+                for (uint32_t x = 0; x < samples; ++x) {
+                    const float h = heights[static_cast<size_t>(cy * chunkCells + y) * samplesX + cx * chunkCells + x];
+                    out[y * samples + x] = h;
+                    record.minHeight = std::min(record.minHeight, h);
+                    record.maxHeight = std::max(record.maxHeight, h);
+                }
+            }
+            offset += sizeof(float) * static_cast<uint64_t>(samples) * samples;
+        }
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(ChunkRecord)));
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(float)));
+    return static_cast<bool>(out);
+}
+
+ATerrain::~ATerrain() {
+    close();
+}
+
+bool ATerrain::open(const std::string& path) {
+    close();
+    file_.open(path, std::ios::binary);
+    if (!file_) {
+        return false;
+    }
+    file_.seekg(0, std::ios::end);
+    const auto fileSize = static_cast<uint64_t>(file_.tellg());
+    file_.seekg(0);
+
+    Header header;
+    file_.read(reinterpret_cast<char*>(&header), sizeof(header));
+    const uint64_t chunkCount = static_cast<uint64_t>(header.chunksX) * header.chunksY;
+    if (!file_ || header.magic != kMagic || header.version != kVersion || chunkCount == 0 ||
+        chunkCount > fileSize / sizeof(ChunkRecord) || header.chunkCells == 0 ||
+        header.chunkCells > kMaxChunkCells || !std::has_single_bit(header.chunkCells) || !(header.cellSize > 0.0f)) {
+        file_.close();
+        return false;
+    }
+    std::vector<ChunkRecord> records(static_cast<size_t>(chunkCount));
+    file_.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(ChunkRecord)));
+    const uint64_t chunkBytes = sizeof(float) * static_cast<uint64_t>(header.chunkCells + 1) * (header.chunkCells + 1);
+    const bool recordsValid = std::all_of(records.begin(), records.end(), [&](const ChunkRecord& record) {
+        return record.offset <= fileSize && chunkBytes <= fileSize - record.offset && record.minHeight <= record.maxHeight;
+    });
+    if (!file_ || !recordsValid) {
+        file_.close();
+        return false;
+    }
+
+    header_ = header;
+    records_ = std::move(records);
+    samples_ = header.chunkCells + 1;
+    lodCount_ = std::min<uint32_t>(kMaxLods, static_cast<uint32_t>(std::countr_zero(header.chunkCells)) + 1);
+    buildLodIndices();
+
+    const float chunkSize = header.cellSize * static_cast<float>(header.chunkCells);
+    chunks_.resize(records_.size());
+    wanted_.assign(records_.size(), 0);
+    minHeight_ = std::numeric_limits<float>::max();
+    maxHeight_ = -std::numeric_limits<float>::max();
+    for (uint32_t cy = 0; cy < header.chunksY; ++cy) {
+        for (uint32_t cx = 0; cx < header.chunksX; ++cx) {
+            const uint32_t index = cy * header.chunksX + cx;
+            const ChunkRecord& record = records_[index];
+            Chunk& chunk = chunks_[index];
+            chunk.boundsMin = glm::vec3(static_cast<float>(cx) * chunkSize, static_cast<float>(cy) * chunkSize, record.minHeight);
+            chunk.boundsMax = glm::vec3(static_cast<float>(cx + 1) * chunkSize, static_cast<float>(cy + 1) * chunkSize, record.maxHeight);
+            minHeight_ = std::min(minHeight_, record.minHeight);
+            maxHeight_ = std::max(maxHeight_, record.maxHeight);
+        }
+    }
+
+    loader_ = std::thread(&ATerrain::loaderLoop, this);
+    return true;
+}
+
+void ATerrain::close() {
+    if (loader_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        loader_.join();
+    }
+    file_.close();
+    file_.clear();
+    queue_.clear();
+    finished_.clear();
+    inFlight_ = kNoChunk;
+    stopping_ = false;
+    records_.clear();
+    chunks_.clear();
+    wanted_.clear();
+    lodIndices_.clear();
+    residentCount_ = 0;
+    requestedCount_ = 0;
+}
+
+void ATerrain::setMemoryBudget(size_t bytes) {
+    memoryBudget_ = bytes;
+}
+
+size_t ATerrain::getMemoryUsage() const {
+    return static_cast<size_t>(residentCount_) * samples_ * samples_ * sizeof(float);
+}
+
+void ATerrain::update(const glm::vec3& camera) {
+    if (chunks_.empty()) {
+        return;
+    }
+
+    // Adopt finished reads; chunks the camera has left since they were queued are dropped.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        adopting_.swap(finished_);
+    }
+    for (LoadResult& result : adopting_) {
+        Chunk& chunk = chunks_[result.chunk];
+        chunk.requested = false;
+        --requestedCount_;
+        if (result.heights.empty()) {
+            chunk.unreadable = true;
+        } else if (wanted_[result.chunk] && !chunk.resident) {
+            chunk.heights = std::move(result.heights);
+            chunk.resident = true;
+            ++residentCount_;
+        }
+    }
+    adopting_.clear();
+
+    // The nearest chunks inside the stream radius that fit the budget are wanted.
+    const size_t chunkBytes = static_cast<size_t>(samples_) * samples_ * sizeof(float);
+    const uint32_t capacity = static_cast<uint32_t>(std::max<size_t>(1, memoryBudget_ / chunkBytes));
+    byDistance_.clear();
+    for (uint32_t i = 0; i < chunks_.size(); ++i) {
+        const Chunk& chunk = chunks_[i];
+        const float dx = std::max({chunk.boundsMin.x - camera.x, 0.0f, camera.x - chunk.boundsMax.x});
+        const float dy = std::max({chunk.boundsMin.y - camera.y, 0.0f, camera.y - chunk.boundsMax.y});
+        const float distance = std::sqrt(dx * dx + dy * dy);
+        if (distance <= streamRadius_ && !chunk.unreadable) {
+            byDistance_.emplace_back(distance, i);
+        }
+    }
+    const size_t wantedCount = std::min<size_t>(capacity, byDistance_.size());
+    std::partial_sort(byDistance_.begin(), byDistance_.begin() + static_cast<std::ptrdiff_t>(wantedCount), byDistance_.end());
+    std::fill(wanted_.begin(), wanted_.end(), uint8_t{0});
+    for (size_t i = 0; i < wantedCount; ++i) {
+        wanted_[byDistance_[i].second] = 1;
+    }
+
+    // Requeue nearest first. The chunk being read stays requested and is adopted next frame.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint32_t queued : queue_) {
+            chunks_[queued].requested = false;
+        }
+        queue_.clear();
+        for (size_t i = 0; i < wantedCount; ++i) {
+            const uint32_t index = byDistance_[i].second;
+            Chunk& chunk = chunks_[index];
+            if (!chunk.resident && index != inFlight_) {
+                chunk.requested = true;
+                queue_.push_back(index);
+            }
+        }
+        requestedCount_ = static_cast<uint32_t>(queue_.size()) + (inFlight_ != kNoChunk ? 1u : 0u);
+    }
+    if (requestedCount_ > 0) {
+        wake_.notify_one();
+    }
+
+    // Make room for the queued chunks by evicting unwanted ones, farthest first.
+    if (residentCount_ + requestedCount_ > capacity) {
+        evictScratch_.clear();
+        for (uint32_t i = 0; i < chunks_.size(); ++i) {
+            if (chunks_[i].resident && !wanted_[i]) {
+                const glm::vec3 center = (chunks_[i].boundsMin + chunks_[i].boundsMax) * 0.5f;
+                evictScratch_.emplace_back(glm::length(glm::vec2(center.x - camera.x, center.y - camera.y)), i);
+            }
+        }
+        std::sort(evictScratch_.begin(), evictScratch_.end(), std::greater<>());
+        for (const auto& [distance, index] : evictScratch_) {
+            if (residentCount_ + requestedCount_ <= capacity) {
+                break;
+            }
+            // Swap with an empty vector so the memory really goes back.
+            std::vector<float>().swap(chunks_[index].heights);
+            chunks_[index].resident = false;
+            --residentCount_;
+        }
+    }
+}
+
+void ATerrain::loaderLoop() {
+    const uint64_t chunkBytes = sizeof(float) * static_cast<uint64_t>(samples_) * samples_;
+    for (;;) {
+        uint32_t chunk = kNoChunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            chunk = queue_.front();
+            queue_.pop_front();
+            inFlight_ = chunk;
+        }
+
+        // The disk read happens outside the lock, so update() never waits on it.
+        LoadResult result;
+        result.chunk = chunk;
+        result.heights.resize(static_cast<size_t>(samples_) * samples_);
+        file_.seekg(static_cast<std::streamoff>(records_[chunk].offset));
+        file_.read(reinterpret_cast<char*>(result.heights.data()), static_cast<std::streamsize>(chunkBytes));
+        if (!file_) {
+            file_.clear();
+            result.heights.clear();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_.push_back(std::move(result));
+        inFlight_ = kNoChunk;
+    }
+}
+
+void ATerrain::buildLodIndices() {
+    lodIndices_.assign(lodCount_, {});
+    for (uint32_t lod = 0; lod < lodCount_; ++lod) {
+        const uint32_t n = (header_.chunkCells >> lod) + 1;
+        std::vector<uint32_t>& indices = lodIndices_[lod];
+        // Every cell is split along the same diagonal as the next coarser level's cells, so a
+        // fully morphed vertex lands exactly on the coarser surface.
+        for (uint32_t j = 0; j + 1 < n; ++j) {
+            for (uint32_t i = 0; i + 1 < n; ++i) {
+                const uint32_t a = j * n + i;
+                const uint32_t b = a + 1;
+                const uint32_t c = a + n;
+                const uint32_t d = c + 1;
+                indices.insert(indices.end(), {a, b, d, a, d, c});
+            }
+        }
+        // Skirt: the border loop extruded downward, stored after the grid vertices.
+        const uint32_t loop = 4 * (n - 1);
+        for (uint32_t k = 0; k < loop; ++k) {
+            const uint32_t next = (k + 1) % loop;
+            const uint32_t v0 = borderVertex(n, k);
+            const uint32_t v1 = borderVertex(n, next);
+            const uint32_t s0 = n * n + k;
+            const uint32_t s1 = n * n + next;
+            indices.insert(indices.end(), {v0, v1, s1, v0, s1, s0});
+        }
+    }
+}
+
+float ATerrain::lodRange(uint32_t lod) const {
+    return lodDistance_ * static_cast<float>(1u << lod);
+}
+
+uint32_t ATerrain::selectLod(uint32_t chunk, const glm::vec3& eye) const {
+    const Chunk& c = chunks_[chunk];
+    const glm::vec3 nearest(std::clamp(eye.x, c.boundsMin.x, c.boundsMax.x),
+                            std::clamp(eye.y, c.boundsMin.y, c.boundsMax.y),
+                            std::clamp(eye.z, c.boundsMin.z, c.boundsMax.z));
+    const float distance = glm::length(nearest - eye);
+    uint32_t lod = 0;
+    while (lod + 1 < lodCount_ && distance > lodRange(lod)) {
+        ++lod;
+    }
+    return lod;
+}
+
+void ATerrain::buildVertices(uint32_t chunk,
+                             uint32_t lod,
+                             const glm::vec3& eye,
+                             std::vector<glm::vec3>& outVertices,
+                             std::vector<AEntity::Color>& outColors) const {
+    const Chunk& c = chunks_[chunk];
+    const uint32_t step = 1u << lod;
+    const uint32_t n = (header_.chunkCells >> lod) + 1;
+    const float* h = c.heights.data();
+    auto height = [&](uint32_t x, uint32_t y) { return h[y * samples_ + x]; };
+
+    const bool canMorph = lod + 1 < lodCount_;
+    const float range = lodRange(lod);
+    const float morphStart = range * kMorphStart;
+    const float heightSpan = std::max(maxHeight_ - minHeight_, 1e-6f);
+
+    outVertices.resize(static_cast<size_t>(n) * n + 4 * (n - 1));
+    outColors.resize(outVertices.size());
+    for (uint32_t j = 0; j < n; ++j) {
+        for (uint32_t i = 0; i < n; ++i) {
+            const uint32_t x = i * step;
+            const uint32_t y = j * step;
+            glm::vec3 position(c.boundsMin.x + static_cast<float>(x) * header_.cellSize,
+                               c.boundsMin.y + static_cast<float>(y) * header_.cellSize,
+                               height(x, y));
+            // Odd vertices blend toward the coarser level's surface, which at their position is
+            // the average of the two even neighbours along the edge (or diagonal) they split.
+            if (canMorph && ((i | j) & 1u)) {
+                float coarse = 0.0f;
+                if ((i & 1u) && (j & 1u)) {
+                    coarse = 0.5f * (height(x - step, y - step) + height(x + step, y + step));
+                } else if (i & 1u) {
+                    coarse = 0.5f * (height(x - step, y) + height(x + step, y));
+                } else {
+                    coarse = 0.5f * (height(x, y - step) + height(x, y + step));
+                }
+                const float morph = std::clamp((glm::length(position - eye) - morphStart) / (range - morphStart), 0.0f, 1.0f);
+                position.z += (coarse - position.z) * morph;
+            }
+            const uint32_t index = j * n + i;
+            outVertices[index] = position;
+            outColors[index] = heightColor((position.z - minHeight_) / heightSpan);
+        }
+    }
+
+    // Deep enough to cover the step to a neighbour one level coarser.
+    const float skirtDepth = static_cast<float>(step) * header_.cellSize + 0.25f * (c.boundsMax.z - c.boundsMin.z);
+    const uint32_t loop = 4 * (n - 1);
+    for (uint32_t k = 0; k < loop; ++k) {
+        const uint32_t border = borderVertex(n, k);
+        outVertices[n * n + k] = outVertices[border] - glm::vec3(0.0f, 0.0f, skirtDepth);
+        outColors[n * n + k] = outColors[border];
+    }
+}
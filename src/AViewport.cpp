@@ -69,6 +69,35 @@ const glm::mat4& AViewport::getProjectionMatrix() const {
     return projection_;
 }
 
+AFrustum AViewport::getFrustum() const {
+    return AFrustum(projection_ * view_);
+}
+
+bool AViewport::getRay(const glm::vec2& point, glm::vec3& outOrigin, glm::vec3& outDirection) const {
+    const float localX = point.x - static_cast<float>(x_);
+    const float localY = point.y - static_cast<float>(y_);
+    if (localX < 0.0f || localY < 0.0f || localX >= static_cast<float>(width_) || localY >= static_cast<float>(height_)) {
+        return false;
+    }
+    // Pixel centers map into NDC with +Y up; unproject the near and far plane points.
+    const float ndcX = (localX + 0.5f) / static_cast<float>(width_) * 2.0f - 1.0f;
+    const float ndcY = 1.0f - (localY + 0.5f) / static_cast<float>(height_) * 2.0f;
+    const glm::mat4 inverse = glm::inverse(projection_ * view_);
+    const glm::vec4 nearPoint = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    const glm::vec4 farPoint = inverse * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    outOrigin = glm::vec3(nearPoint) / nearPoint.w;
+    outDirection = glm::normalize(glm::vec3(farPoint) / farPoint.w - outOrigin);
+    return true;
+}
+
+void AViewport::setLodErrorThreshold(float pixels) {
+    lodErrorThreshold_ = pixels;
+}
+
+float AViewport::getLodErrorThreshold() const {
+    return lodErrorThreshold_;
+}
+
 void AViewport::addOverlay(ARenderOverlay& overlay) {
     overlays_.push_back(&overlay);
 }
@@ -1,31 +1,68 @@
 #include <AWindow>
 
+#include <AFrameArena>
 #include <IWindowImpl.h>
-#include <Win32/AWindowImplWin32.h>
+#include <Offscreen/AWindowImplOffscreen.h>
 #include <Graphics/IRendererImpl.h>
+#include <Graphics/Headless/HeadlessRenderer.h>
+#ifdef _WIN32
+#include <Win32/AWindowImplWin32.h>
+#endif
+#ifdef MYGAME_ENABLE_OPENGL
 #include <Graphics/OpenGL/OpenGLRenderer.h>
+#endif
+#ifdef MYGAME_ENABLE_VULKAN
 #include <Graphics/Vulkan/VulkanRenderer.h>
+#endif
+#ifdef MYGAME_ENABLE_DX11
 #include <Graphics/DirectX11/DirectX11Renderer.h>
+#endif
+#ifdef MYGAME_ENABLE_DX12
 #include <Graphics/DirectX12/DirectX12Renderer.h>
+#endif
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 
 namespace {
 
 std::unique_ptr<IRendererImpl> createRenderer(EGraphicsBackend backend) {
     switch (backend) {
+#ifdef MYGAME_ENABLE_OPENGL
     case EGraphicsBackend::OpenGL:
         return std::make_unique<OpenGLRenderer>();
+#endif
+#ifdef MYGAME_ENABLE_VULKAN
     case EGraphicsBackend::Vulkan:
         return std::make_unique<VulkanRenderer>();
+#endif
+#ifdef MYGAME_ENABLE_DX11
     case EGraphicsBackend::DirectX11:
         return std::make_unique<DirectX11Renderer>();
+#endif
+#ifdef MYGAME_ENABLE_DX12
     case EGraphicsBackend::DirectX12:
         return std::make_unique<DirectX12Renderer>();
+#endif
+    case EGraphicsBackend::Headless:
+        return std::make_unique<HeadlessRenderer>();
     default:
         return nullptr;
     }
 }
 
+std::unique_ptr<IWindowImpl> createWindowImpl(EGraphicsBackend backend) {
+#ifdef _WIN32
+    if (backend != EGraphicsBackend::Headless) {
+        return std::make_unique<AWindowImplWin32>();
+    }
+#else
+    (void)backend;
+#endif
+    return std::make_unique<AWindowImplOffscreen>();
+}
+
 } // namespace
 
 AWindow::AWindow(const std::string& title, int width, int height, EGraphicsBackend backend)
@@ -35,10 +72,14 @@ AWindow::AWindow(AWindow& parent, int x, int y, int width, int height, EGraphics
     : AWindow("", width, height, parent.getNativeHandle(), x, y, true, backend) {}
 
 AWindow::AWindow(const std::string& title, int width, int height, void* parentHandle, int x, int y, bool child, EGraphicsBackend backend)
-    : viewport_(width, height, 0, 0), backend_(backend) {
-    impl_ = std::make_unique<AWindowImplWin32>();
+    : backend_(backend) {
+    rendererPool_.resize(static_cast<size_t>(EGraphicsBackend::Headless) + 1);
+    viewports_.push_back(std::make_unique<AViewport>(width, height, 0, 0));
+    viewportLayouts_.push_back(ViewportLayout{});
+    // Headless windows (and every window on platforms without a native implementation) live offscreen.
+    impl_ = createWindowImpl(backend_);
     const bool created = impl_->create(title, width, height, parentHandle, x, y, child);
-    assert(created && "Failed to create Win32 window");
+    assert(created && "Failed to create window");
     if (backend_ != EGraphicsBackend::None) {
         recreateRenderer(width, height);
     }
@@ -48,6 +89,7 @@ AWindow::~AWindow() {
     if (renderer_) {
         renderer_->shutdown();
     }
+    releaseRendererPool();
 }
 
 bool AWindow::isOpen() const {
@@ -66,9 +108,9 @@ void AWindow::setTitle(const std::string& title) {
     }
 }
 
-std::vector<std::shared_ptr<AEvent>> AWindow::pollEvents() {
+std::pmr::vector<AEvent> AWindow::pollEvents() {
     if (!impl_) {
-        return {};
+        return std::pmr::vector<AEvent>(&AFrameArena::current());
     }
     return impl_->pollEvents();
 }
@@ -102,27 +144,56 @@ void AWindow::setRect(int x, int y, int width, int height) {
     if (impl_) {
         impl_->setRect(x, y, width, height);
     }
-    viewport_.setRect(0, 0, width, height);
-    lastWidth_ = -1;
-    lastHeight_ = -1;
+    applyViewportLayouts(width, height);
 }
 
 void AWindow::display() {
     if (!renderer_) {
         return;
     }
+    buildFrame(commandList_);
+    presentFrame(commandList_);
+}
 
+void AWindow::buildFrame(ARenderCommandList& commands) {
     const int w = getWidth();
     const int h = getHeight();
+    if (w != layoutWidth_ || h != layoutHeight_) {
+        applyViewportLayouts(w, h);
+    }
+
+    commands.clear();
+    viewportScratch_.clear();
+    for (const auto& viewport : viewports_) {
+        viewportScratch_.push_back(viewport.get());
+    }
+    commands.appendViewports(viewportScratch_);
+    commands.sort();
+    commands.setSurfaceSize(w, h);
+}
+
+void AWindow::presentFrame(const ARenderCommandList& commands) {
+    if (!renderer_) {
+        return;
+    }
+
+    const int w = commands.getSurfaceWidth();
+    const int h = commands.getSurfaceHeight();
     if (w != lastWidth_ || h != lastHeight_) {
-        viewport_.setRect(0, 0, w, h);
         renderer_->resize(w, h);
         lastWidth_ = w;
         lastHeight_ = h;
     }
 
-    renderer_->setWorld(viewport_.getWorld());
-    renderer_->draw(viewport_);
+    renderer_->draw(commands);
+}
+
+bool AWindow::getGpuTime(double& outMilliseconds) const {
+    return renderer_ ? renderer_->getGpuTime(outMilliseconds) : false;
+}
+
+bool AWindow::readPixels(std::vector<uint8_t>& outBgra, int& outWidth, int& outHeight) const {
+    return renderer_ ? renderer_->readPixels(outBgra, outWidth, outHeight) : false;
 }
 
 void AWindow::setGraphicsBackend(EGraphicsBackend backend) {
@@ -130,22 +201,113 @@ void AWindow::setGraphicsBackend(EGraphicsBackend backend) {
         return;
     }
 
-    backend_ = backend;
+    const auto start = std::chrono::steady_clock::now();
+    bool warm = false;
+
     if (renderer_) {
-        renderer_->shutdown();
+        if (rendererPoolEnabled_) {
+            rendererPool_[static_cast<size_t>(backend_)] = std::move(renderer_);
+        } else {
+            renderer_->shutdown();
+        }
     }
     renderer_.reset();
+
+    backend_ = backend;
     if (backend_ != EGraphicsBackend::None) {
-        recreateRenderer(getWidth(), getHeight());
+        const int w = getWidth();
+        const int h = getHeight();
+        auto& pooled = rendererPool_[static_cast<size_t>(backend_)];
+        if (pooled) {
+            renderer_ = std::move(pooled);
+            renderer_->resize(w, h);
+            lastWidth_ = w;
+            lastHeight_ = h;
+            warm = true;
+        } else {
+            recreateRenderer(w, h);
+        }
     }
+
+    lastSwitchMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    lastSwitchWarm_ = warm;
 }
 
 EGraphicsBackend AWindow::getGraphicsBackend() const {
     return backend_;
 }
 
+void AWindow::setRendererPoolEnabled(bool enabled) {
+    rendererPoolEnabled_ = enabled;
+    if (!rendererPoolEnabled_) {
+        releaseRendererPool();
+    }
+}
+
+bool AWindow::isRendererPoolEnabled() const {
+    return rendererPoolEnabled_;
+}
+
+double AWindow::getLastBackendSwitchMilliseconds() const {
+    return lastSwitchMs_;
+}
+
+bool AWindow::wasLastBackendSwitchWarm() const {
+    return lastSwitchWarm_;
+}
+
+void AWindow::releaseRendererPool() {
+    for (auto& pooled : rendererPool_) {
+        if (pooled) {
+            pooled->shutdown();
+            pooled.reset();
+        }
+    }
+}
+
 AViewport& AWindow::getViewport() {
-    return viewport_;
+    return *viewports_.front();
+}
+
+AViewport& AWindow::addViewport(float x, float y, float width, float height) {
+    viewports_.push_back(std::make_unique<AViewport>(1, 1, 0, 0));
+    viewportLayouts_.push_back(ViewportLayout{x, y, width, height});
+    AViewport& viewport = *viewports_.back();
+    if (AWorld* world = getViewport().getWorld()) {
+        viewport.setWorld(*world);
+    }
+    applyViewportLayouts(getWidth(), getHeight());
+    return viewport;
+}
+
+void AWindow::setViewportLayout(size_t index, float x, float y, float width, float height) {
+    if (index >= viewportLayouts_.size()) {
+        return;
+    }
+    viewportLayouts_[index] = ViewportLayout{x, y, width, height};
+    applyViewportLayouts(getWidth(), getHeight());
+}
+
+size_t AWindow::getViewportCount() const {
+    return viewports_.size();
+}
+
+AViewport& AWindow::getViewport(size_t index) {
+    return *viewports_[index];
+}
+
+void AWindow::applyViewportLayouts(int width, int height) {
+    layoutWidth_ = width;
+    layoutHeight_ = height;
+    for (size_t i = 0; i < viewports_.size(); ++i) {
+        const ViewportLayout& layout = viewportLayouts_[i];
+        // Round both edges so neighbouring viewports tile the surface without gaps or overlap.
+        const int x0 = static_cast<int>(std::lround(layout.x * static_cast<float>(width)));
+        const int y0 = static_cast<int>(std::lround(layout.y * static_cast<float>(height)));
+        const int x1 = static_cast<int>(std::lround((layout.x + layout.width) * static_cast<float>(width)));
+        const int y1 = static_cast<int>(std::lround((layout.y + layout.height) * static_cast<float>(height)));
+        viewports_[i]->setRect(x0, y0, std::max(1, x1 - x0), std::max(1, y1 - y0));
+    }
 }
 
 void AWindow::recreateRenderer(int width, int height) {
@@ -160,5 +322,4 @@ void AWindow::recreateRenderer(int width, int height) {
     }
     lastWidth_ = width;
     lastHeight_ = height;
-    renderer_->setWorld(viewport_.getWorld());
 }
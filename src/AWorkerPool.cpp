@@ -0,0 +1,100 @@
+#include <AWorkerPool>
+
+namespace {
+
+// Set on workers and, while its job runs, on the thread that issued it; parallelFor() calls made
+// from there run inline instead of waiting on (or re-locking) the job they are part of.
+thread_local bool insidePoolJob = false;
+
+} // namespace
+
+AWorkerPool::AWorkerPool(uint32_t workerCount) {
+    workers_.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&AWorkerPool::workerLoop, this);
+    }
+}
+
+AWorkerPool::~AWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+AWorkerPool& AWorkerPool::shared() {
+    static AWorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+void AWorkerPool::run(size_t chunks, Invoke invoke, void* context) {
+    std::unique_lock<std::mutex> runLock(runMutex_, std::defer_lock);
+    // insidePoolJob is tested first: the issuing thread already holds runMutex_ during its job.
+    if (chunks <= 1 || workers_.empty() || insidePoolJob || !runLock.try_lock()) {
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            invoke(context, chunk);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        invoke_ = invoke;
+        context_ = context;
+        chunkCount_ = chunks;
+        pendingChunks_ = chunks;
+        nextChunk_.store(0, std::memory_order_relaxed);
+        open_ = true;
+        ++job_;
+    }
+    start_.notify_all();
+
+    insidePoolJob = true;
+    const size_t ran = work();
+    insidePoolJob = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    pendingChunks_ -= ran;
+    // Close the job only once no worker is inside it, so a late one cannot pick up a chunk of
+    // the next job with this one's context.
+    done_.wait(lock, [this] { return pendingChunks_ == 0 && activeWorkers_ == 0; });
+    open_ = false;
+}
+
+size_t AWorkerPool::work() {
+    size_t ran = 0;
+    for (;;) {
+        const size_t chunk = nextChunk_.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= chunkCount_) {
+            return ran;
+        }
+        invoke_(context_, chunk);
+        ++ran;
+    }
+}
+
+void AWorkerPool::workerLoop() {
+    insidePoolJob = true;
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&] { return stopping_ || (open_ && job_ != seen); });
+            if (stopping_) {
+                return;
+            }
+            seen = job_;
+            ++activeWorkers_;
+        }
+        const size_t ran = work();
+        std::lock_guard<std::mutex> lock(mutex_);
+        --activeWorkers_;
+        pendingChunks_ -= ran;
+        if (pendingChunks_ == 0 && activeWorkers_ == 0) {
+            done_.notify_one();
+        }
+    }
+}
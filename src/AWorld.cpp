@@ -1,24 +1,1686 @@
 #include <AWorld>
 #include <AFloatingText>
+#include <AViewport>
 
-void AWorld::addEntity(AEntity* entity) {
-    if (!entity) {
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define AW_RAYCAST_SSE 1
+#endif
+
+namespace {
+
+// FNV-1a over the raw bytes; collisions are resolved by comparing content.
+uint64_t hashBytes(const void* data, size_t size, uint64_t hash) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Smaller meshes are cheap enough that a LOD chain would cost more in bookkeeping than it saves.
+constexpr uint32_t kLodMinTriangles = 64;
+// Caps each collapse at this fraction of the mesh diagonal so coarse levels keep their silhouette.
+constexpr float kLodMaxRelativeError = 0.1f;
+constexpr uint32_t kNoVertex = 0xFFFFFFFFu;
+
+uint64_t nextMeshKey() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+// Large enough that a batch amortizes a draw, small enough that culling still discards most of a level.
+constexpr uint32_t kStaticBatchVertices = 32768;
+
+// Spreads the low 10 bits of v so two zero bits follow each one (for 30-bit Morton codes).
+uint32_t spreadBits(uint32_t v) {
+    v &= 0x3FFu;
+    v = (v | (v << 16)) & 0x030000FFu;
+    v = (v | (v << 8)) & 0x0300F00Fu;
+    v = (v | (v << 4)) & 0x030C30C3u;
+    v = (v | (v << 2)) & 0x09249249u;
+    return v;
+}
+
+// Meshes up to this size are tested triangle by triangle; larger ones get a triangle BVH.
+constexpr uint32_t kRaycastBruteForceTriangles = 64;
+constexpr uint32_t kNoTriangle = 0xFFFFFFFFu;
+
+bool rayHitsBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& invDirection, float limit) {
+    float tMin = 0.0f;
+    float tMax = limit;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float t0 = (min[axis] - origin[axis]) * invDirection[axis];
+        const float t1 = (max[axis] - origin[axis]) * invDirection[axis];
+        tMin = std::max(tMin, std::min(t0, t1));
+        tMax = std::min(tMax, std::max(t0, t1));
+    }
+    return tMin <= tMax;
+}
+
+// Möller-Trumbore against up to four triangles at once, both faces. Returns the slot in
+// `triangles` of the nearest hit closer than limit, lowering limit to it, or -1.
+int intersectTriangles(const glm::vec3& origin,
+                       const glm::vec3& direction,
+                       std::span<const glm::vec3> vertices,
+                       std::span<const uint32_t> indices,
+                       const uint32_t* triangles,
+                       uint32_t count,
+                       float& limit) {
+#if AW_RAYCAST_SSE
+    // Short groups repeat their last triangle, which can only tie with itself.
+    alignas(16) float lanes[9][4];
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        const uint32_t triangle = triangles[std::min(lane, count - 1)];
+        const glm::vec3& a = vertices[indices[triangle * 3]];
+        const glm::vec3 e1 = vertices[indices[triangle * 3 + 1]] - a;
+        const glm::vec3 e2 = vertices[indices[triangle * 3 + 2]] - a;
+        const float values[9] = {a.x, a.y, a.z, e1.x, e1.y, e1.z, e2.x, e2.y, e2.z};
+        for (int component = 0; component < 9; ++component) {
+            lanes[component][lane] = values[component];
+        }
+    }
+    const __m128 dx = _mm_set1_ps(direction.x);
+    const __m128 dy = _mm_set1_ps(direction.y);
+    const __m128 dz = _mm_set1_ps(direction.z);
+    const __m128 sx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(lanes[0]));
+    const __m128 sy = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(lanes[1]));
+    const __m128 sz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(lanes[2]));
+    const __m128 e1x = _mm_load_ps(lanes[3]);
+    const __m128 e1y = _mm_load_ps(lanes[4]);
+    const __m128 e1z = _mm_load_ps(lanes[5]);
+    const __m128 e2x = _mm_load_ps(lanes[6]);
+    const __m128 e2y = _mm_load_ps(lanes[7]);
+    const __m128 e2z = _mm_load_ps(lanes[8]);
+
+    // p = d x e2, q = s x e1.
+    const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    auto dot = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+    };
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 det = dot(e1x, e1y, e1z, px, py, pz);
+    const __m128 inverseDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    const __m128 u = _mm_mul_ps(dot(sx, sy, sz, px, py, pz), inverseDet);
+    const __m128 v = _mm_mul_ps(dot(dx, dy, dz, qx, qy, qz), inverseDet);
+    const __m128 t = _mm_mul_ps(dot(e2x, e2y, e2z, qx, qy, qz), inverseDet);
+    __m128 hit = _mm_cmpneq_ps(det, zero);
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(t, zero));
+    hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_set1_ps(limit)));
+    const int mask = _mm_movemask_ps(hit);
+    if (mask == 0) {
+        return -1;
+    }
+    alignas(16) float distances[4];
+    _mm_store_ps(distances, t);
+    int nearest = -1;
+    for (int lane = 0; lane < static_cast<int>(count); ++lane) {
+        if ((mask & (1 << lane)) != 0 && distances[lane] < limit) {
+            limit = distances[lane];
+            nearest = lane;
+        }
+    }
+    return nearest;
+#else
+    int nearest = -1;
+    for (uint32_t slot = 0; slot < count; ++slot) {
+        const uint32_t triangle = triangles[slot];
+        const glm::vec3& a = vertices[indices[triangle * 3]];
+        const glm::vec3 e1 = vertices[indices[triangle * 3 + 1]] - a;
+        const glm::vec3 e2 = vertices[indices[triangle * 3 + 2]] - a;
+        const glm::vec3 p = glm::cross(direction, e2);
+        const float det = glm::dot(e1, p);
+        if (det == 0.0f) {
+            continue;
+        }
+        const float inverseDet = 1.0f / det;
+        const glm::vec3 s = origin - a;
+        const float u = glm::dot(s, p) * inverseDet;
+        const glm::vec3 q = glm::cross(s, e1);
+        const float v = glm::dot(direction, q) * inverseDet;
+        const float t = glm::dot(e2, q) * inverseDet;
+        if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < limit) {
+            limit = t;
+            nearest = static_cast<int>(slot);
+        }
+    }
+    return nearest;
+#endif
+}
+
+// Nearest hit among the listed triangles, or kNoTriangle; lowers limit like intersectTriangles.
+uint32_t intersectTriangleList(const glm::vec3& origin,
+                               const glm::vec3& direction,
+                               std::span<const glm::vec3> vertices,
+                               std::span<const uint32_t> indices,
+                               std::span<const uint32_t> triangles,
+                               float& limit) {
+    uint32_t nearest = kNoTriangle;
+    for (size_t first = 0; first < triangles.size(); first += 4) {
+        const auto count = static_cast<uint32_t>(std::min<size_t>(4, triangles.size() - first));
+        const int slot = intersectTriangles(origin, direction, vertices, indices, triangles.data() + first, count, limit);
+        if (slot >= 0) {
+            nearest = triangles[first + slot];
+        }
+    }
+    return nearest;
+}
+
+} // namespace
+
+AMesh AWorld::createMesh(std::span<const glm::vec3> vertices, std::span<const AEntity::Color> vertexColors) {
+    // Convex polygon: triangulate once here as a fan instead of in every renderer every frame.
+    meshIndexScratch_.clear();
+    for (uint32_t i = 1; i + 1 < vertices.size(); ++i) {
+        meshIndexScratch_.insert(meshIndexScratch_.end(), {0u, i, i + 1});
+    }
+    return registerMesh(vertices, vertexColors);
+}
+
+AMesh AWorld::createMesh(std::span<const glm::vec3> vertices,
+                         std::span<const uint32_t> indices,
+                         std::span<const AEntity::Color> vertexColors) {
+    meshIndexScratch_.assign(indices.begin(), indices.end());
+    return registerMesh(vertices, vertexColors);
+}
+
+AMesh AWorld::registerMesh(std::span<const glm::vec3> vertices, std::span<const AEntity::Color> vertexColors) {
+    // Reordering before hashing keeps deduplication exact: the optimizer is deterministic, so
+    // identical input always lands on identical stored triangles.
+    if (!meshOptimizer_.optimizeVertexCache(meshIndexScratch_, static_cast<uint32_t>(vertices.size()))) {
+        return AMesh();
+    }
+
+    const bool hasColors = !vertexColors.empty() && vertexColors.size() == vertices.size();
+    uint64_t hash = hashBytes(vertices.data(), vertices.size_bytes(), 14695981039346656037ull);
+    hash = hashBytes(meshIndexScratch_.data(), meshIndexScratch_.size() * sizeof(uint32_t), hash);
+    if (hasColors) {
+        hash = hashBytes(vertexColors.data(), vertexColors.size_bytes(), hash ^ 0x9E3779B97F4A7C15ull);
+    }
+
+    const auto range = meshesByHash_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        const MeshData& mesh = meshes_[it->second];
+        if (mesh.vertexCount != vertices.size() || mesh.indexCount != meshIndexScratch_.size() ||
+            mesh.hasVertexColors != hasColors) {
+            continue;
+        }
+        const MeshGeometry existing = getMeshGeometry(it->second);
+        const bool sameVertices = std::equal(vertices.begin(), vertices.end(), existing.vertices.begin());
+        const bool sameIndices = std::equal(meshIndexScratch_.begin(), meshIndexScratch_.end(), existing.indices.begin());
+        const bool sameColors = !hasColors ||
+            std::memcmp(vertexColors.data(), existing.vertexColors.data(), vertexColors.size_bytes()) == 0;
+        if (sameVertices && sameIndices && sameColors) {
+            return AMesh(this, it->second, mesh.generation);
+        }
+    }
+
+    // The input may point into the pools (e.g. re-coloring an existing mesh); growing them below
+    // would invalidate it, so take a copy first.
+    meshVertexScratch_.assign(vertices.begin(), vertices.end());
+    if (hasColors) {
+        meshColorScratch_.assign(vertexColors.begin(), vertexColors.end());
+    }
+
+    uint32_t id = 0;
+    if (!freeMeshes_.empty()) {
+        id = freeMeshes_.back();
+        freeMeshes_.pop_back();
+    } else {
+        id = static_cast<uint32_t>(meshes_.size());
+        meshes_.push_back(MeshData{});
+    }
+
+    const uint32_t count = static_cast<uint32_t>(meshVertexScratch_.size());
+    MeshData& mesh = meshes_[id];
+    mesh.key = nextMeshKey();
+    mesh.hash = hash;
+    mesh.source = 0;
+    mesh.firstVertex = allocateVertices(count);
+    mesh.vertexCount = count;
+    mesh.firstIndex = allocateIndices(static_cast<uint32_t>(meshIndexScratch_.size()));
+    mesh.indexCount = static_cast<uint32_t>(meshIndexScratch_.size());
+    mesh.entityCount = 0;
+    mesh.hasVertexColors = hasColors;
+    mesh.alive = true;
+    std::copy(meshVertexScratch_.begin(), meshVertexScratch_.end(), vertexPool_.begin() + mesh.firstVertex);
+    std::copy(meshIndexScratch_.begin(), meshIndexScratch_.end(), indexPool_.begin() + mesh.firstIndex);
+    if (hasColors) {
+        std::copy(meshColorScratch_.begin(), meshColorScratch_.end(), vertexColorPool_.begin() + mesh.firstVertex);
+    }
+
+    mesh.boundsMin = glm::vec3(0.0f);
+    mesh.boundsMax = glm::vec3(0.0f);
+    if (count > 0) {
+        mesh.boundsMin = meshVertexScratch_[0];
+        mesh.boundsMax = meshVertexScratch_[0];
+        for (const auto& v : meshVertexScratch_) {
+            mesh.boundsMin = glm::min(mesh.boundsMin, v);
+            mesh.boundsMax = glm::max(mesh.boundsMax, v);
+        }
+    }
+    // Sphere around the box center; slightly looser than a minimal sphere but stable and cheap.
+    mesh.sphereCenter = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+    mesh.sphereRadius = 0.0f;
+    for (const auto& v : meshVertexScratch_) {
+        mesh.sphereRadius = std::max(mesh.sphereRadius, glm::length(v - mesh.sphereCenter));
+    }
+
+    buildLods(mesh);
+    meshesByHash_.emplace(hash, id);
+    return AMesh(this, id, mesh.generation);
+}
+
+void AWorld::buildLods(MeshData& mesh) {
+    mesh.lods[0] = MeshLod{mesh.firstVertex, mesh.vertexCount, mesh.firstIndex, mesh.indexCount, 0.0f};
+    mesh.lodCount = 1;
+    if (mesh.indexCount / 3 < kLodMinTriangles) {
+        return;
+    }
+
+    // Each level targets a quarter of the previous one and is simplified from the full mesh,
+    // so errors do not compound down the chain.
+    const float maxError = glm::length(mesh.boundsMax - mesh.boundsMin) * kLodMaxRelativeError;
+    uint32_t previous = mesh.indexCount;
+    for (uint32_t level = 1; level < kMaxMeshLods; ++level) {
+        const uint32_t target = previous / 12 * 3;
+        if (target / 3 < kLodMinTriangles / 4) {
+            break;
+        }
+        const float error = meshSimplifier_.simplify(meshVertexScratch_, meshIndexScratch_, target, maxError, lodIndexScratch_);
+        if (lodIndexScratch_.size() * 4 > static_cast<size_t>(previous) * 3) {
+            break; // Stuck on borders or the error cap; another level would barely help.
+        }
+
+        // Keep only the vertices this level still references, in first-use order.
+        lodRemapScratch_.assign(mesh.vertexCount, kNoVertex);
+        lodVertexScratch_.clear();
+        lodColorScratch_.clear();
+        for (uint32_t& index : lodIndexScratch_) {
+            if (lodRemapScratch_[index] == kNoVertex) {
+                lodRemapScratch_[index] = static_cast<uint32_t>(lodVertexScratch_.size());
+                lodVertexScratch_.push_back(meshVertexScratch_[index]);
+                if (mesh.hasVertexColors) {
+                    lodColorScratch_.push_back(meshColorScratch_[index]);
+                }
+            }
+            index = lodRemapScratch_[index];
+        }
+        const uint32_t vertexCount = static_cast<uint32_t>(lodVertexScratch_.size());
+        meshOptimizer_.optimizeVertexCache(lodIndexScratch_, vertexCount);
+
+        MeshLod& lod = mesh.lods[level];
+        lod.firstVertex = allocateVertices(vertexCount);
+        lod.vertexCount = vertexCount;
+        lod.firstIndex = allocateIndices(static_cast<uint32_t>(lodIndexScratch_.size()));
+        lod.indexCount = static_cast<uint32_t>(lodIndexScratch_.size());
+        lod.error = error;
+        std::copy(lodVertexScratch_.begin(), lodVertexScratch_.end(), vertexPool_.begin() + lod.firstVertex);
+        std::copy(lodIndexScratch_.begin(), lodIndexScratch_.end(), indexPool_.begin() + lod.firstIndex);
+        if (mesh.hasVertexColors) {
+            std::copy(lodColorScratch_.begin(), lodColorScratch_.end(), vertexColorPool_.begin() + lod.firstVertex);
+        }
+        mesh.lodCount = level + 1;
+        previous = lod.indexCount;
+    }
+}
+
+bool AWorld::isAlive(const AMesh& mesh) const {
+    return mesh.getWorld() == this && mesh.getId() < meshes_.size() &&
+           meshes_[mesh.getId()].alive && meshes_[mesh.getId()].generation == mesh.getGeneration();
+}
+
+AMesh AWorld::getMesh(uint32_t meshId) {
+    return AMesh(this, meshId, meshes_[meshId].generation);
+}
+
+void AWorld::releaseUnusedMeshes() {
+    for (uint32_t id = 0; id < meshes_.size(); ++id) {
+        MeshData& mesh = meshes_[id];
+        if (!mesh.alive || mesh.entityCount > 0 || mesh.batchCount > 0) {
+            continue;
+        }
+        const auto range = meshesByHash_.equal_range(mesh.hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                meshesByHash_.erase(it);
+                break;
+            }
+        }
+        // Scene geometry belongs to the mapping; only pool ranges are recycled.
+        for (uint32_t level = 0; level < mesh.lodCount && mesh.source == 0; ++level) {
+            freeVertexRanges_[mesh.lods[level].vertexCount].push_back(mesh.lods[level].firstVertex);
+            freeIndexRanges_[mesh.lods[level].indexCount].push_back(mesh.lods[level].firstIndex);
+        }
+        pendingChanges_.releasedMeshKeys_.push_back(mesh.key);
+        if (id < triangleBvhs_.size()) {
+            triangleBvhs_[id].reset();
+        }
+        mesh.alive = false;
+        ++mesh.generation;
+        freeMeshes_.push_back(id);
+    }
+}
+
+AInstanceBatch AWorld::addInstances(const AMesh& mesh,
+                                    std::span<const glm::mat4> transforms,
+                                    std::span<const AEntity::Color> colors) {
+    if (!isAlive(mesh) || (!colors.empty() && colors.size() != transforms.size())) {
+        return {};
+    }
+
+    uint32_t id = 0;
+    if (!freeInstanceBatches_.empty()) {
+        id = freeInstanceBatches_.back();
+        freeInstanceBatches_.pop_back();
+    } else {
+        id = static_cast<uint32_t>(instanceBatches_.size());
+        instanceBatches_.emplace_back();
+    }
+    InstanceBatchData& batch = instanceBatches_[id];
+    batch.meshId = mesh.getId();
+    batch.alive = true;
+    ++meshes_[batch.meshId].batchCount;
+
+    const uint32_t count = static_cast<uint32_t>(transforms.size());
+    batch.instances.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        batch.instances[i].transform = transforms[i];
+        batch.instances[i].color = colors.empty() ? AEntity::Color{} : colors[i];
+    }
+    batch.spheres.resize(count);
+    const uint32_t chunkCount = (count + kInstanceChunkSize - 1) / kInstanceChunkSize;
+    batch.chunkMin.resize(chunkCount);
+    batch.chunkMax.resize(chunkCount);
+    updateInstanceBounds(batch, 0, count);
+    return AInstanceBatch(this, id, batch.generation);
+}
+
+bool AWorld::setInstanceTransforms(const AInstanceBatch& batch, uint32_t first, std::span<const glm::mat4> transforms) {
+    if (!isAlive(batch)) {
+        return false;
+    }
+    InstanceBatchData& data = instanceBatches_[batch.getId()];
+    if (first > data.instances.size() || transforms.size() > data.instances.size() - first) {
+        return false;
+    }
+    const uint32_t end = first + static_cast<uint32_t>(transforms.size());
+    for (uint32_t i = first; i < end; ++i) {
+        data.instances[i].transform = transforms[i - first];
+    }
+    updateInstanceBounds(data, first, end);
+    return true;
+}
+
+bool AWorld::setInstanceColors(const AInstanceBatch& batch, uint32_t first, std::span<const AEntity::Color> colors) {
+    if (!isAlive(batch)) {
+        return false;
+    }
+    InstanceBatchData& data = instanceBatches_[batch.getId()];
+    if (first > data.instances.size() || colors.size() > data.instances.size() - first) {
+        return false;
+    }
+    for (size_t i = 0; i < colors.size(); ++i) {
+        data.instances[first + i].color = colors[i];
+    }
+    return true;
+}
+
+void AWorld::removeInstances(const AInstanceBatch& batch) {
+    if (!isAlive(batch)) {
+        return;
+    }
+    InstanceBatchData& data = instanceBatches_[batch.getId()];
+    --meshes_[data.meshId].batchCount;
+    // Give the memory back; a batch can hold millions of instances.
+    std::vector<AInstance>().swap(data.instances);
+    std::vector<glm::vec4>().swap(data.spheres);
+    std::vector<glm::vec3>().swap(data.chunkMin);
+    std::vector<glm::vec3>().swap(data.chunkMax);
+    data.alive = false;
+    ++data.generation;
+    freeInstanceBatches_.push_back(batch.getId());
+}
+
+bool AWorld::isAlive(const AInstanceBatch& batch) const {
+    return batch.getWorld() == this && batch.getId() < instanceBatches_.size() &&
+           instanceBatches_[batch.getId()].alive && instanceBatches_[batch.getId()].generation == batch.getGeneration();
+}
+
+void AWorld::updateInstanceBounds(InstanceBatchData& batch, uint32_t first, uint32_t end) {
+    if (first >= end) {
+        return;
+    }
+    const MeshData& mesh = meshes_[batch.meshId];
+    for (uint32_t i = first; i < end; ++i) {
+        const glm::mat4& m = batch.instances[i].transform;
+        const float scale = std::max({glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))});
+        batch.spheres[i] = glm::vec4(glm::vec3(m * glm::vec4(mesh.sphereCenter, 1.0f)), mesh.sphereRadius * scale);
+    }
+
+    const uint32_t count = static_cast<uint32_t>(batch.instances.size());
+    for (uint32_t chunk = first / kInstanceChunkSize; chunk <= (end - 1) / kInstanceChunkSize; ++chunk) {
+        glm::vec3 chunkMin(std::numeric_limits<float>::max());
+        glm::vec3 chunkMax(-std::numeric_limits<float>::max());
+        const uint32_t chunkEnd = std::min(count, (chunk + 1) * kInstanceChunkSize);
+        for (uint32_t i = chunk * kInstanceChunkSize; i < chunkEnd; ++i) {
+            const glm::vec3 center(batch.spheres[i]);
+            chunkMin = glm::min(chunkMin, center - batch.spheres[i].w);
+            chunkMax = glm::max(chunkMax, center + batch.spheres[i].w);
+        }
+        batch.chunkMin[chunk] = chunkMin;
+        batch.chunkMax[chunk] = chunkMax;
+    }
+
+    // The batch box is a pass over chunk boxes, 1/64th of the instances.
+    batch.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    batch.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    for (size_t chunk = 0; chunk < batch.chunkMin.size(); ++chunk) {
+        batch.boundsMin = glm::min(batch.boundsMin, batch.chunkMin[chunk]);
+        batch.boundsMax = glm::max(batch.boundsMax, batch.chunkMax[chunk]);
+    }
+}
+
+AEntity AWorld::createEntity(std::span<const glm::vec3> vertices) {
+    return createEntity(createMesh(vertices));
+}
+
+AEntity AWorld::createEntity(const AMesh& mesh) {
+    const uint32_t index = getEntityCount();
+
+    uint32_t id = 0;
+    if (!freeSlots_.empty()) {
+        id = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        id = static_cast<uint32_t>(slots_.size());
+        slots_.push_back(Slot{});
+    }
+    slots_[id].dense = index;
+    slots_[id].alive = true;
+    denseToSlot_.push_back(id);
+
+    positions_.emplace_back(0.0f);
+    rotations_.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+    scales_.emplace_back(1.0f);
+    parents_.push_back(kNoParent);
+    worldMatrices_.emplace_back(1.0f);
+    dirty_.push_back(0);
+    static_.push_back(0);
+    colors_.push_back(AEntity::Color{});
+    boundsMin_.emplace_back(0.0f);
+    boundsMax_.emplace_back(0.0f);
+    sphereCenters_.emplace_back(0.0f);
+    sphereRadii_.push_back(0.0f);
+    meshIds_.push_back(kNoMesh);
+    worldBoundsMin_.emplace_back(0.0f);
+    worldBoundsMax_.emplace_back(0.0f);
+    assignMesh(index, isAlive(mesh) ? mesh.getId() : createMesh({}).getId());
+    // Identity transform until the first updateTransforms(), so world bounds start as local ones.
+    worldBoundsMin_[index] = boundsMin_[index];
+    worldBoundsMax_[index] = boundsMax_[index];
+    addUnindexed(id);
+    spatialHash_.update(id, glm::vec3(0.0f));
+    broadphase_.update(id, worldBoundsMin_[index], worldBoundsMax_[index]);
+    insertLevelEntry(id, 0);
+    recordChange(id, AChangeJournal::EntityAdded);
+    return AEntity(this, id, slots_[id].generation);
+}
+
+AEntity AWorld::createTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    const glm::vec3 verts[] = {a, b, c};
+    return createEntity(verts);
+}
+
+AEntity AWorld::createRectangle(float width, float height) {
+    const float hw = width * 0.5f;
+    const float hh = height * 0.5f;
+    const glm::vec3 verts[] = {
+        {-hw, -hh, 0.0f},
+        { hw, -hh, 0.0f},
+        { hw,  hh, 0.0f},
+        {-hw,  hh, 0.0f},
+    };
+    return createEntity(verts);
+}
+
+bool AWorld::loadScene(const std::string& path) {
+    auto scene = std::make_unique<ASceneFile>();
+    if (!scene->open(path)) {
+        return false;
+    }
+
+    // Check every range a renderer will index with before anything is added to the world.
+    const auto sceneMeshes = scene->getMeshes();
+    const size_t sceneVertices = scene->getVertices().size();
+    const size_t sceneIndices = scene->getIndices().size();
+    const bool colorsParallel = scene->getVertexColors().size() == sceneVertices;
+    for (const auto& record : sceneMeshes) {
+        if (record.lodCount == 0 || record.lodCount > kMaxMeshLods || (record.hasVertexColors && !colorsParallel)) {
+            return false;
+        }
+        for (uint32_t level = 0; level < record.lodCount; ++level) {
+            const ASceneFile::LodRecord& lod = record.lods[level];
+            if (lod.firstVertex > sceneVertices || lod.vertexCount > sceneVertices - lod.firstVertex ||
+                lod.firstIndex > sceneIndices || lod.indexCount > sceneIndices - lod.firstIndex) {
+                return false;
+            }
+        }
+    }
+    const auto positions = scene->getEntityPositions();
+    const auto rotations = scene->getEntityRotations();
+    const auto scales = scene->getEntityScales();
+    const auto colors = scene->getEntityColors();
+    const auto entityMeshes = scene->getEntityMeshes();
+    const auto parents = scene->getEntityParents();
+    const uint32_t count = static_cast<uint32_t>(positions.size());
+    if (rotations.size() != count || scales.size() != count || colors.size() != count ||
+        entityMeshes.size() != count || parents.size() != count) {
+        return false;
+    }
+    // Parents must be in range and acyclic; state 1 = on the current walk, 2 = known to reach a root.
+    std::vector<uint8_t> state(count, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (entityMeshes[i] >= sceneMeshes.size()) {
+            return false;
+        }
+        uint32_t cursor = i;
+        while (cursor != ASceneFile::kNoParent && state[cursor] == 0) {
+            state[cursor] = 1;
+            cursor = parents[cursor];
+            if (cursor != ASceneFile::kNoParent && cursor >= count) {
+                return false;
+            }
+        }
+        if (cursor != ASceneFile::kNoParent && state[cursor] == 1) {
+            return false;
+        }
+        for (cursor = i; cursor != ASceneFile::kNoParent && state[cursor] == 1; cursor = parents[cursor]) {
+            state[cursor] = 2;
+        }
+    }
+
+    // Meshes reference the mapping directly.
+    const uint32_t source = static_cast<uint32_t>(scenes_.size()) + 1;
+    std::vector<uint32_t> meshIds(sceneMeshes.size());
+    for (size_t m = 0; m < sceneMeshes.size(); ++m) {
+        const ASceneFile::MeshRecord& record = sceneMeshes[m];
+        uint32_t id = 0;
+        if (!freeMeshes_.empty()) {
+            id = freeMeshes_.back();
+            freeMeshes_.pop_back();
+        } else {
+            id = static_cast<uint32_t>(meshes_.size());
+            meshes_.push_back(MeshData{});
+        }
+        MeshData& mesh = meshes_[id];
+        mesh.key = nextMeshKey();
+        mesh.hash = record.hash;
+        mesh.source = source;
+        mesh.entityCount = 0;
+        mesh.hasVertexColors = record.hasVertexColors != 0;
+        mesh.alive = true;
+        mesh.lodCount = record.lodCount;
+        for (uint32_t level = 0; level < record.lodCount; ++level) {
+            const ASceneFile::LodRecord& lod = record.lods[level];
+            mesh.lods[level] = MeshLod{lod.firstVertex, lod.vertexCount, lod.firstIndex, lod.indexCount, lod.error};
+        }
+        mesh.firstVertex = mesh.lods[0].firstVertex;
+        mesh.vertexCount = mesh.lods[0].vertexCount;
+        mesh.firstIndex = mesh.lods[0].firstIndex;
+        mesh.indexCount = mesh.lods[0].indexCount;
+        mesh.boundsMin = glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]);
+        mesh.boundsMax = glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]);
+        mesh.sphereCenter = glm::vec3(record.sphereCenter[0], record.sphereCenter[1], record.sphereCenter[2]);
+        mesh.sphereRadius = record.sphereRadius;
+        meshesByHash_.emplace(mesh.hash, id);
+        meshIds[m] = id;
+    }
+    scenes_.push_back(std::move(scene));
+
+    // Entities: bulk appends onto the SoA arrays. Loaded slots are fresh and contiguous so file
+    // parent indices translate by offset.
+    const uint32_t first = getEntityCount();
+    const uint32_t firstSlot = static_cast<uint32_t>(slots_.size());
+    const size_t total = static_cast<size_t>(first) + count;
+    slots_.resize(slots_.size() + count);
+    denseToSlot_.reserve(total);
+    rotations_.reserve(total);
+    parents_.reserve(total);
+    meshIds_.reserve(total);
+    boundsMin_.reserve(total);
+    boundsMax_.reserve(total);
+    sphereCenters_.reserve(total);
+    sphereRadii_.reserve(total);
+    unindexed_.reserve(unindexed_.size() + count);
+    positions_.insert(positions_.end(), positions.begin(), positions.end());
+    scales_.insert(scales_.end(), scales.begin(), scales.end());
+    colors_.insert(colors_.end(), colors.begin(), colors.end());
+    worldMatrices_.resize(total, glm::mat4(1.0f));
+    dirty_.resize(total, 1);
+    static_.resize(total, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t slot = firstSlot + i;
+        slots_[slot].dense = first + i;
+        slots_[slot].alive = true;
+        denseToSlot_.push_back(slot);
+        rotations_.emplace_back(rotations[i].w, rotations[i].x, rotations[i].y, rotations[i].z);
+        parents_.push_back(parents[i] == ASceneFile::kNoParent ? kNoParent : firstSlot + parents[i]);
+
+        const uint32_t meshId = meshIds[entityMeshes[i]];
+        MeshData& mesh = meshes_[meshId];
+        ++mesh.entityCount;
+        meshIds_.push_back(meshId);
+        boundsMin_.push_back(mesh.boundsMin);
+        boundsMax_.push_back(mesh.boundsMax);
+        sphereCenters_.push_back(mesh.sphereCenter);
+        sphereRadii_.push_back(mesh.sphereRadius);
+        addUnindexed(slot);
+        recordChange(slot, AChangeJournal::EntityAdded);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        if (parents[i] != ASceneFile::kNoParent) {
+            linkChild(firstSlot + parents[i], firstSlot + i);
+        }
+    }
+    // World bounds come from the first updateTransforms(); loaded entities are all dirty.
+    worldBoundsMin_.insert(worldBoundsMin_.end(), boundsMin_.begin() + first, boundsMin_.end());
+    worldBoundsMax_.insert(worldBoundsMax_.end(), boundsMax_.begin() + first, boundsMax_.end());
+    anyDirty_ = anyDirty_ || count > 0;
+    hierarchyChanged_ = true;
+
+    const ASceneFile& loaded = *scenes_.back();
+    for (const auto& record : loaded.getTexts()) {
+        const glm::vec3 position(record.position[0], record.position[1], record.position[2]);
+        const AEntity::Color color{record.color[0], record.color[1], record.color[2], record.color[3]};
+        addFloatingText(AFloatingText(std::string(loaded.getText(record)), position, record.pixelHeight, color));
+    }
+    return true;
+}
+
+uint32_t AWorld::allocateVertices(uint32_t count) {
+    auto it = freeVertexRanges_.find(count);
+    if (it != freeVertexRanges_.end() && !it->second.empty()) {
+        const uint32_t first = it->second.back();
+        it->second.pop_back();
+        return first;
+    }
+    const uint32_t first = static_cast<uint32_t>(vertexPool_.size());
+    vertexPool_.resize(vertexPool_.size() + count);
+    vertexColorPool_.resize(vertexPool_.size());
+    return first;
+}
+
+uint32_t AWorld::allocateIndices(uint32_t count) {
+    auto it = freeIndexRanges_.find(count);
+    if (it != freeIndexRanges_.end() && !it->second.empty()) {
+        const uint32_t first = it->second.back();
+        it->second.pop_back();
+        return first;
+    }
+    const uint32_t first = static_cast<uint32_t>(indexPool_.size());
+    indexPool_.resize(indexPool_.size() + count);
+    return first;
+}
+
+void AWorld::destroyEntity(AEntity entity) {
+    if (entity.getWorld() != this || !isAlive(entity)) {
+        return;
+    }
+    // Invalidates every copy of the handle right away; the data stays until flushRemovals().
+    slots_[entity.getId()].alive = false;
+    pendingRemovals_.push_back(entity.getId());
+    recordChange(entity.getId(), AChangeJournal::EntityRemoved);
+}
+
+void AWorld::destroyFloatingText(const AFloatingText* text) {
+    if (text) {
+        pendingTextRemovals_.push_back(text);
+    }
+}
+
+void AWorld::flushRemovals() {
+    for (uint32_t id : pendingRemovals_) {
+        // Children become roots, keeping their local transform.
+        while (slots_[id].firstChild != kNoSlot) {
+            const uint32_t child = slots_[id].firstChild;
+            unlinkChild(child);
+            parents_[slots_[child].dense] = kNoParent;
+            markDirty(slots_[child].dense);
+            placeSubtree(child, 0);
+        }
+        if (parents_[slots_[id].dense] != kNoParent) {
+            unlinkChild(id);
+        }
+        eraseLevelEntry(id);
+        removeAt(slots_[id].dense);
+        // The slot is reusable only now, so a queued id can never alias a newer entity.
+        ++slots_[id].generation;
+        freeSlots_.push_back(id);
+    }
+    pendingRemovals_.clear();
+
+    for (const AFloatingText* text : pendingTextRemovals_) {
+        auto it = std::find_if(floatingTexts_.begin(), floatingTexts_.end(),
+                               [text](const auto& owned) { return owned.get() == text; });
+        if (it != floatingTexts_.end()) {
+            std::swap(*it, floatingTexts_.back());
+            floatingTexts_.pop_back();
+            markTextsChanged();
+        }
+    }
+    pendingTextRemovals_.clear();
+
+    for (const AParticleSystem* system : pendingParticleRemovals_) {
+        auto it = std::find_if(particleSystems_.begin(), particleSystems_.end(),
+                               [system](const auto& owned) { return owned.get() == system; });
+        if (it != particleSystems_.end()) {
+            std::swap(*it, particleSystems_.back());
+            particleSystems_.pop_back();
+        }
+    }
+    pendingParticleRemovals_.clear();
+}
+
+void AWorld::removeAt(uint32_t index) {
+    const uint32_t id = denseToSlot_[index];
+    spatialHash_.remove(id);
+    broadphase_.remove(id);
+    if (bvh_.contains(id)) {
+        bvh_.remove(id);
+    } else {
+        removeUnindexed(id);
+    }
+    --meshes_[meshIds_[index]].entityCount;
+    staticChanged_ = staticChanged_ || static_[index];
+
+    const uint32_t last = getEntityCount() - 1;
+    if (index != last) {
+        positions_[index] = positions_[last];
+        rotations_[index] = rotations_[last];
+        scales_[index] = scales_[last];
+        parents_[index] = parents_[last];
+        worldMatrices_[index] = worldMatrices_[last];
+        dirty_[index] = dirty_[last];
+        static_[index] = static_[last];
+        colors_[index] = colors_[last];
+        boundsMin_[index] = boundsMin_[last];
+        boundsMax_[index] = boundsMax_[last];
+        sphereCenters_[index] = sphereCenters_[last];
+        sphereRadii_[index] = sphereRadii_[last];
+        worldBoundsMin_[index] = worldBoundsMin_[last];
+        worldBoundsMax_[index] = worldBoundsMax_[last];
+        meshIds_[index] = meshIds_[last];
+        denseToSlot_[index] = denseToSlot_[last];
+        const uint32_t moved = denseToSlot_[index];
+        slots_[moved].dense = index;
+        // Point the hierarchy order at the entity's new dense index.
+        if (!hierarchyChanged_) {
+            levelOrder_[slots_[moved].levelPosition] = index;
+            for (uint32_t child = slots_[moved].firstChild; child != kNoSlot; child = slots_[child].nextSibling) {
+                levelOrderParent_[slots_[child].levelPosition] = index;
+            }
+        }
+    }
+    positions_.pop_back();
+    rotations_.pop_back();
+    scales_.pop_back();
+    parents_.pop_back();
+    worldMatrices_.pop_back();
+    dirty_.pop_back();
+    static_.pop_back();
+    colors_.pop_back();
+    boundsMin_.pop_back();
+    boundsMax_.pop_back();
+    sphereCenters_.pop_back();
+    sphereRadii_.pop_back();
+    worldBoundsMin_.pop_back();
+    worldBoundsMax_.pop_back();
+    meshIds_.pop_back();
+    denseToSlot_.pop_back();
+}
+
+void AWorld::assignMesh(uint32_t index, uint32_t meshId) {
+    if (meshIds_[index] != kNoMesh) {
+        --meshes_[meshIds_[index]].entityCount;
+    }
+    meshIds_[index] = meshId;
+    MeshData& mesh = meshes_[meshId];
+    ++mesh.entityCount;
+    boundsMin_[index] = mesh.boundsMin;
+    boundsMax_[index] = mesh.boundsMax;
+    sphereCenters_[index] = mesh.sphereCenter;
+    sphereRadii_[index] = mesh.sphereRadius;
+}
+
+void AWorld::updateWorldBounds(uint32_t index) {
+    // World box enclosing the transformed local box: |M| * extents around the moved center.
+    const glm::mat4& m = worldMatrices_[index];
+    const glm::vec3 extents = (boundsMax_[index] - boundsMin_[index]) * 0.5f;
+    const glm::vec3 worldExtents = glm::abs(glm::vec3(m[0])) * extents.x +
+                                   glm::abs(glm::vec3(m[1])) * extents.y +
+                                   glm::abs(glm::vec3(m[2])) * extents.z;
+    const glm::vec3 center = glm::vec3(m * glm::vec4((boundsMin_[index] + boundsMax_[index]) * 0.5f, 1.0f));
+    worldBoundsMin_[index] = center - worldExtents;
+    worldBoundsMax_[index] = center + worldExtents;
+}
+
+void AWorld::rebuildBvh() {
+    const uint32_t count = getEntityCount();
+    buildIds_.assign(denseToSlot_.begin(), denseToSlot_.end());
+    buildMins_.assign(worldBoundsMin_.begin(), worldBoundsMin_.end());
+    buildMaxs_.assign(worldBoundsMax_.begin(), worldBoundsMax_.end());
+    bvh_.build(std::span<const uint32_t>(buildIds_.data(), count), buildMins_, buildMaxs_);
+    for (uint32_t id : unindexed_) {
+        slots_[id].unindexedPosition = kNoSlot;
+    }
+    unindexed_.clear();
+    bvhRefits_ = 0;
+}
+
+void AWorld::slotsToDense(std::vector<uint32_t>& ids, size_t first) const {
+    for (size_t i = first; i < ids.size(); ++i) {
+        ids[i] = slots_[ids[i]].dense;
+    }
+}
+
+void AWorld::cullEntities(const AFrustum& frustum, std::vector<uint32_t>& outVisible) const {
+    cullEntities(std::span<const AFrustum>(&frustum, 1), std::span<std::vector<uint32_t>>(&outVisible, 1));
+}
+
+void AWorld::cullEntities(std::span<const AFrustum> frustums, std::span<std::vector<uint32_t>> outVisible) const {
+    for (size_t base = 0; base < frustums.size(); base += ABvh::kMaxFrustums) {
+        const size_t count = std::min<size_t>(ABvh::kMaxFrustums, frustums.size() - base);
+        const auto frustumBatch = frustums.subspan(base, count);
+        const auto outBatch = outVisible.subspan(base, count);
+
+        std::array<size_t, ABvh::kMaxFrustums> firstNew{};
+        for (size_t f = 0; f < count; ++f) {
+            firstNew[f] = outBatch[f].size();
+        }
+        bvh_.queryFrustums(frustumBatch, outBatch);
+        for (size_t f = 0; f < count; ++f) {
+            slotsToDense(outBatch[f], firstNew[f]);
+        }
+    }
+
+    for (uint32_t id : unindexed_) {
+        const uint32_t index = slots_[id].dense;
+        const glm::vec3 center = (worldBoundsMin_[index] + worldBoundsMax_[index]) * 0.5f;
+        const glm::vec3 extents = (worldBoundsMax_[index] - worldBoundsMin_[index]) * 0.5f;
+        for (size_t f = 0; f < frustums.size(); ++f) {
+            if (frustums[f].intersectsAabb(center, extents)) {
+                outVisible[f].push_back(index);
+            }
+        }
+    }
+}
+
+void AWorld::rebuildSpatialHash() {
+    const uint32_t count = getEntityCount();
+    hashPositions_.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        hashPositions_[i] = glm::vec3(worldMatrices_[i][3]);
+    }
+    spatialHash_.rebuild(denseToSlot_, hashPositions_);
+}
+
+void AWorld::queryNeighbors(const glm::vec3& center, float radius, std::vector<uint32_t>& outIndices) const {
+    const size_t first = outIndices.size();
+    spatialHash_.queryRadius(center, radius, outIndices);
+    slotsToDense(outIndices, first);
+}
+
+void AWorld::queryNeighborsInBox(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& outIndices) const {
+    const size_t first = outIndices.size();
+    spatialHash_.queryAabb(min, max, outIndices);
+    slotsToDense(outIndices, first);
+}
+
+void AWorld::queryNearest(const glm::vec3& point, uint32_t k, std::vector<uint32_t>& outIndices, float maxDistance) const {
+    const size_t first = outIndices.size();
+    spatialHash_.queryNearest(point, k, outIndices, maxDistance);
+    slotsToDense(outIndices, first);
+}
+
+void AWorld::findOverlappingPairs(std::vector<ABroadphase::Pair>& outPairs, bool parallel) {
+    if (parallel) {
+        broadphase_.findPairsParallel(outPairs);
+    } else {
+        broadphase_.findPairs(outPairs);
+    }
+    for (ABroadphase::Pair& pair : outPairs) {
+        pair.a = slots_[pair.a].dense;
+        pair.b = slots_[pair.b].dense;
+    }
+}
+
+void AWorld::queryAabb(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& outIndices) const {
+    const size_t first = outIndices.size();
+    bvh_.queryAabb(min, max, outIndices);
+    slotsToDense(outIndices, first);
+    for (uint32_t id : unindexed_) {
+        const uint32_t index = slots_[id].dense;
+        const glm::vec3& boxMin = worldBoundsMin_[index];
+        const glm::vec3& boxMax = worldBoundsMax_[index];
+        if (boxMin.x <= max.x && boxMax.x >= min.x &&
+            boxMin.y <= max.y && boxMax.y >= min.y &&
+            boxMin.z <= max.z && boxMax.z >= min.z) {
+            outIndices.push_back(index);
+        }
+    }
+}
+
+void AWorld::querySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& outIndices) const {
+    const size_t first = outIndices.size();
+    bvh_.querySphere(center, radius, outIndices);
+    slotsToDense(outIndices, first);
+    for (uint32_t id : unindexed_) {
+        const uint32_t index = slots_[id].dense;
+        const glm::vec3 d = glm::min(glm::max(center, worldBoundsMin_[index]), worldBoundsMax_[index]) - center;
+        if (glm::dot(d, d) <= radius * radius) {
+            outIndices.push_back(index);
+        }
+    }
+}
+
+void AWorld::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& outIndices) const {
+    const size_t first = outIndices.size();
+    bvh_.queryRay(origin, direction, maxDistance, outIndices);
+    slotsToDense(outIndices, first);
+    if (unindexed_.empty()) {
         return;
     }
-    entities_.emplace_back(entity);
+    const glm::vec3 unit = glm::normalize(direction);
+    for (uint32_t id : unindexed_) {
+        const uint32_t index = slots_[id].dense;
+        float tMin = 0.0f;
+        float tMax = maxDistance;
+        for (int axis = 0; axis < 3 && tMin <= tMax; ++axis) {
+            float t0 = (worldBoundsMin_[index][axis] - origin[axis]) / unit[axis];
+            float t1 = (worldBoundsMax_[index][axis] - origin[axis]) / unit[axis];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+        }
+        if (tMin <= tMax) {
+            outIndices.push_back(index);
+        }
+    }
+}
+
+bool AWorld::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& outHit) const {
+    const glm::vec3 unit = glm::normalize(direction);
+    const glm::vec3 invDirection(1.0f / unit.x, 1.0f / unit.y, 1.0f / unit.z);
+    auto testEntity = [&](uint32_t index, float limit) {
+        if (!rayHitsBox(worldBoundsMin_[index], worldBoundsMax_[index], origin, invDirection, limit)) {
+            return limit;
+        }
+        return raycastEntity(index, origin, unit, limit, outHit);
+    };
+    float limit = bvh_.raycast(origin, unit, maxDistance, [&](std::span<const uint32_t> ids, float leafLimit) {
+        for (uint32_t id : ids) {
+            leafLimit = testEntity(slots_[id].dense, leafLimit);
+        }
+        return leafLimit;
+    });
+    for (uint32_t id : unindexed_) {
+        limit = testEntity(slots_[id].dense, limit);
+    }
+    return limit < maxDistance;
+}
+
+bool AWorld::pick(const AViewport& viewport, const glm::vec2& point, RayHit& outHit) const {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    return viewport.getRay(point, origin, direction) &&
+           raycast(origin, direction, std::numeric_limits<float>::max(), outHit);
+}
+
+float AWorld::raycastEntity(uint32_t index, const glm::vec3& origin, const glm::vec3& direction, float limit, RayHit& outHit) const {
+    const uint32_t meshId = meshIds_[index];
+    if (meshId == kNoMesh) {
+        return limit;
+    }
+    // The local direction keeps its scale, so local hit distances are world distances.
+    const glm::mat4 toLocal = glm::inverse(worldMatrices_[index]);
+    const glm::vec3 localOrigin(toLocal * glm::vec4(origin, 1.0f));
+    const glm::vec3 localDirection(toLocal * glm::vec4(direction, 0.0f));
+    const MeshGeometry geometry = getMeshGeometry(meshId, 0);
+    const auto triangleCount = static_cast<uint32_t>(geometry.indices.size() / 3);
+
+    uint32_t triangle = kNoTriangle;
+    if (triangleCount <= kRaycastBruteForceTriangles) {
+        std::array<uint32_t, kRaycastBruteForceTriangles> all;
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            all[t] = t;
+        }
+        triangle = intersectTriangleList(localOrigin, localDirection, geometry.vertices, geometry.indices,
+                                         std::span<const uint32_t>(all.data(), triangleCount), limit);
+    } else {
+        limit = getTriangleBvh(meshId).raycast(localOrigin, localDirection, limit, [&](std::span<const uint32_t> ids, float leafLimit) {
+            const uint32_t hit = intersectTriangleList(localOrigin, localDirection, geometry.vertices, geometry.indices, ids, leafLimit);
+            if (hit != kNoTriangle) {
+                triangle = hit;
+            }
+            return leafLimit;
+        });
+    }
+    if (triangle != kNoTriangle) {
+        outHit.index = index;
+        outHit.triangle = triangle;
+        outHit.distance = limit;
+        outHit.position = origin + direction * limit;
+    }
+    return limit;
 }
 
-const std::vector<std::unique_ptr<AEntity>>& AWorld::getEntities() const {
-    return entities_;
+const ABvh& AWorld::getTriangleBvh(uint32_t meshId) const {
+    if (triangleBvhs_.size() < meshes_.size()) {
+        triangleBvhs_.resize(meshes_.size());
+    }
+    std::unique_ptr<ABvh>& bvh = triangleBvhs_[meshId];
+    if (!bvh) {
+        const MeshGeometry geometry = getMeshGeometry(meshId, 0);
+        const auto triangleCount = static_cast<uint32_t>(geometry.indices.size() / 3);
+        std::vector<uint32_t> ids(triangleCount);
+        std::vector<glm::vec3> mins(triangleCount);
+        std::vector<glm::vec3> maxs(triangleCount);
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            const glm::vec3& a = geometry.vertices[geometry.indices[t * 3]];
+            const glm::vec3& b = geometry.vertices[geometry.indices[t * 3 + 1]];
+            const glm::vec3& c = geometry.vertices[geometry.indices[t * 3 + 2]];
+            ids[t] = t;
+            mins[t] = glm::min(glm::min(a, b), c);
+            maxs[t] = glm::max(glm::max(a, b), c);
+        }
+        bvh = std::make_unique<ABvh>();
+        bvh->build(ids, mins, maxs);
+    }
+    return *bvh;
 }
 
-void AWorld::addFloatingText(AFloatingText* text) {
-    if (!text) {
+void AWorld::cullInstances(uint32_t batchId, const AFrustum& frustum, std::vector<uint32_t>& outVisible) const {
+    const InstanceBatchData& batch = instanceBatches_[batchId];
+    if (!batch.alive || batch.instances.empty() ||
+        !frustum.intersectsAabb((batch.boundsMin + batch.boundsMax) * 0.5f, (batch.boundsMax - batch.boundsMin) * 0.5f)) {
         return;
     }
-    floatingTexts_.emplace_back(text);
+    const uint32_t count = static_cast<uint32_t>(batch.instances.size());
+    for (uint32_t chunk = 0; chunk < batch.chunkMin.size(); ++chunk) {
+        const glm::vec3 center = (batch.chunkMin[chunk] + batch.chunkMax[chunk]) * 0.5f;
+        const glm::vec3 extents = (batch.chunkMax[chunk] - batch.chunkMin[chunk]) * 0.5f;
+        const AFrustum::Containment containment = frustum.classifyAabb(center, extents);
+        if (containment == AFrustum::Containment::Outside) {
+            continue;
+        }
+        const uint32_t first = chunk * kInstanceChunkSize;
+        const uint32_t end = std::min(count, first + kInstanceChunkSize);
+        for (uint32_t i = first; i < end; ++i) {
+            if (containment == AFrustum::Containment::Inside ||
+                frustum.intersectsSphere(glm::vec3(batch.spheres[i]), batch.spheres[i].w)) {
+                outVisible.push_back(i);
+            }
+        }
+    }
+}
+
+bool AWorld::setParent(const AEntity& child, const AEntity& parent) {
+    if (child.getWorld() != this || !isAlive(child)) {
+        return false;
+    }
+    const uint32_t index = getIndex(child);
+    uint32_t newParent = kNoParent;
+    if (parent.getWorld() != nullptr && parent.isValid()) {
+        if (parent.getWorld() != this) {
+            return false;
+        }
+        // Walk up from the new parent; meeting the child means the link would close a loop.
+        for (uint32_t id = parent.getId(); id != kNoParent; id = parents_[slots_[id].dense]) {
+            if (id == child.getId()) {
+                return false;
+            }
+        }
+        newParent = parent.getId();
+    }
+    if (parents_[index] != kNoParent) {
+        unlinkChild(child.getId());
+    }
+    parents_[index] = newParent;
+    if (newParent != kNoParent) {
+        linkChild(newParent, child.getId());
+    }
+    markDirty(index);
+    if (!hierarchyChanged_) {
+        placeSubtree(child.getId(), newParent == kNoParent ? 0 : getLevel(newParent) + 1);
+    }
+    return true;
+}
+
+uint32_t AWorld::getParentIndex(uint32_t index) const {
+    const uint32_t parent = parents_[index];
+    return parent == kNoParent ? kNoParent : slots_[parent].dense;
 }
 
-const std::vector<std::unique_ptr<AFloatingText>>& AWorld::getFloatingTexts() const {
+AEntity AWorld::getParent(const AEntity& child) {
+    if (child.getWorld() != this || !isAlive(child)) {
+        return {};
+    }
+    const uint32_t id = parents_[getIndex(child)];
+    if (id == kNoParent) {
+        return {};
+    }
+    return AEntity(this, id, slots_[id].generation);
+}
+
+void AWorld::markDirty(uint32_t index) {
+    dirty_[index] = 1;
+    anyDirty_ = true;
+}
+
+void AWorld::recordChange(uint32_t id, uint8_t flags) {
+    if (id >= changeEntry_.size()) {
+        changeEntry_.resize(slots_.size(), kNoChange);
+    }
+    auto& entities = pendingChanges_.entities_;
+    const uint32_t entry = changeEntry_[id];
+    // A slot recycled within the frame gets a fresh entry so the old generation's removal survives.
+    if (entry != kNoChange && entities[entry].generation == slots_[id].generation) {
+        entities[entry].flags |= flags;
+        return;
+    }
+    changeEntry_[id] = static_cast<uint32_t>(entities.size());
+    entities.push_back(AChangeJournal::EntityChange{id, slots_[id].generation, flags});
+}
+
+void AWorld::commitChanges() {
+    for (const auto& change : pendingChanges_.entities_) {
+        changeEntry_[change.id] = kNoChange;
+    }
+    // Swap so both journals keep their capacity and steady frames do not allocate.
+    const uint64_t frame = changes_.frame_ + 1;
+    std::swap(changes_, pendingChanges_);
+    changes_.frame_ = frame;
+    pendingChanges_.clear();
+}
+
+void AWorld::rebuildHierarchyOrder() {
+    const uint32_t count = getEntityCount();
+
+    // Depth of every entity, resolved by walking up to the nearest ancestor with a known depth.
+    depthScratch_.assign(count, kNoParent);
+    uint32_t maxDepth = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t steps = 0;
+        uint32_t cursor = i;
+        while (depthScratch_[cursor] == kNoParent && parents_[cursor] != kNoParent) {
+            cursor = slots_[parents_[cursor]].dense;
+            ++steps;
+        }
+        uint32_t depth = depthScratch_[cursor] == kNoParent ? 0 : depthScratch_[cursor];
+        depthScratch_[cursor] = depth;
+        depth += steps;
+        maxDepth = std::max(maxDepth, depth);
+        for (cursor = i; depthScratch_[cursor] == kNoParent; cursor = slots_[parents_[cursor]].dense) {
+            depthScratch_[cursor] = depth--;
+        }
+    }
+
+    // Counting sort by depth keeps the order stable within a level and needs no allocation
+    // once the buffers have grown.
+    levelStart_.assign(static_cast<size_t>(maxDepth) + 2, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        ++levelStart_[depthScratch_[i] + 1];
+    }
+    for (size_t level = 1; level < levelStart_.size(); ++level) {
+        levelStart_[level] += levelStart_[level - 1];
+    }
+    levelOrder_.resize(count);
+    levelOrderParent_.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t slot = levelStart_[depthScratch_[i]]++;
+        levelOrder_[slot] = i;
+        levelOrderParent_[slot] = parents_[i] == kNoParent ? kNoParent : slots_[parents_[i]].dense;
+        slots_[denseToSlot_[i]].levelPosition = slot;
+    }
+    // The fill pass advanced each start to the next level's start; shift back.
+    for (size_t level = levelStart_.size() - 1; level > 0; --level) {
+        levelStart_[level] = levelStart_[level - 1];
+    }
+    levelStart_[0] = 0;
+    hierarchyChanged_ = false;
+}
+
+void AWorld::linkChild(uint32_t parent, uint32_t child) {
+    Slot& childSlot = slots_[child];
+    childSlot.prevSibling = kNoSlot;
+    childSlot.nextSibling = slots_[parent].firstChild;
+    if (childSlot.nextSibling != kNoSlot) {
+        slots_[childSlot.nextSibling].prevSibling = child;
+    }
+    slots_[parent].firstChild = child;
+}
+
+void AWorld::unlinkChild(uint32_t child) {
+    Slot& childSlot = slots_[child];
+    if (childSlot.prevSibling != kNoSlot) {
+        slots_[childSlot.prevSibling].nextSibling = childSlot.nextSibling;
+    } else {
+        slots_[parents_[childSlot.dense]].firstChild = childSlot.nextSibling;
+    }
+    if (childSlot.nextSibling != kNoSlot) {
+        slots_[childSlot.nextSibling].prevSibling = childSlot.prevSibling;
+    }
+    childSlot.prevSibling = kNoSlot;
+    childSlot.nextSibling = kNoSlot;
+}
+
+void AWorld::moveLevelEntry(uint32_t from, uint32_t to) {
+    if (from == to) {
+        return;
+    }
+    levelOrder_[to] = levelOrder_[from];
+    levelOrderParent_[to] = levelOrderParent_[from];
+    slots_[denseToSlot_[levelOrder_[to]]].levelPosition = to;
+}
+
+uint32_t AWorld::getLevel(uint32_t id) const {
+    const auto next = std::upper_bound(levelStart_.begin(), levelStart_.end(), slots_[id].levelPosition);
+    return static_cast<uint32_t>(next - levelStart_.begin()) - 1;
+}
+
+void AWorld::insertLevelEntry(uint32_t id, uint32_t depth) {
+    if (hierarchyChanged_) {
+        return;
+    }
+    if (levelStart_.empty()) {
+        levelStart_.push_back(0);
+    }
+    while (levelStart_.size() - 1 <= depth) {
+        levelStart_.push_back(levelStart_.back());
+    }
+    // Open a hole at the very end, then walk it down: each deeper level hands its first entry
+    // to the hole at its end and starts one later, until the hole sits at the end of `depth`.
+    uint32_t hole = levelStart_.back();
+    levelOrder_.push_back(0);
+    levelOrderParent_.push_back(0);
+    ++levelStart_.back();
+    for (size_t level = levelStart_.size() - 2; level > depth; --level) {
+        const uint32_t first = levelStart_[level];
+        moveLevelEntry(first, hole);
+        hole = first;
+        ++levelStart_[level];
+    }
+    const uint32_t index = slots_[id].dense;
+    levelOrder_[hole] = index;
+    levelOrderParent_[hole] = parents_[index] == kNoParent ? kNoParent : slots_[parents_[index]].dense;
+    slots_[id].levelPosition = hole;
+}
+
+void AWorld::eraseLevelEntry(uint32_t id) {
+    if (hierarchyChanged_) {
+        return;
+    }
+    // The reverse walk: each level's last entry fills the hole, which then becomes the first
+    // position of the next level.
+    uint32_t hole = slots_[id].levelPosition;
+    for (size_t level = getLevel(id); level + 1 < levelStart_.size(); ++level) {
+        const uint32_t last = --levelStart_[level + 1];
+        moveLevelEntry(last, hole);
+        hole = last;
+    }
+    levelOrder_.pop_back();
+    levelOrderParent_.pop_back();
+    slots_[id].levelPosition = kNoSlot;
+    while (levelStart_.size() > 2 && levelStart_[levelStart_.size() - 2] == levelStart_.back()) {
+        levelStart_.pop_back();
+    }
+}
+
+void AWorld::placeSubtree(uint32_t id, uint32_t depth) {
+    if (hierarchyChanged_) {
+        return;
+    }
+    if (getLevel(id) == depth) {
+        // Same depth under another parent: descendants keep their levels too.
+        const uint32_t index = slots_[id].dense;
+        levelOrderParent_[slots_[id].levelPosition] = parents_[index] == kNoParent ? kNoParent : slots_[parents_[index]].dense;
+        return;
+    }
+    subtreeScratch_.clear();
+    subtreeScratch_.emplace_back(id, depth);
+    while (!subtreeScratch_.empty()) {
+        const auto [entity, level] = subtreeScratch_.back();
+        subtreeScratch_.pop_back();
+        eraseLevelEntry(entity);
+        insertLevelEntry(entity, level);
+        for (uint32_t child = slots_[entity].firstChild; child != kNoSlot; child = slots_[child].nextSibling) {
+            subtreeScratch_.emplace_back(child, level + 1);
+        }
+    }
+}
+
+void AWorld::addUnindexed(uint32_t id) {
+    slots_[id].unindexedPosition = static_cast<uint32_t>(unindexed_.size());
+    unindexed_.push_back(id);
+}
+
+void AWorld::removeUnindexed(uint32_t id) {
+    const uint32_t position = slots_[id].unindexedPosition;
+    if (position == kNoSlot) {
+        return;
+    }
+    const uint32_t last = unindexed_.back();
+    unindexed_[position] = last;
+    slots_[last].unindexedPosition = position;
+    unindexed_.pop_back();
+    slots_[id].unindexedPosition = kNoSlot;
+}
+
+void AWorld::updateTransforms() {
+    if (hierarchyChanged_) {
+        rebuildHierarchyOrder();
+    }
+
+    if (anyDirty_) {
+        // Parents always sit in an earlier level, so by the time a level runs every parent's world
+        // matrix and dirty bit are final. Entries inside one level are independent of each other,
+        // which keeps the loop body a straight batch over flat arrays.
+        for (size_t level = 0; level + 1 < levelStart_.size(); ++level) {
+            for (uint32_t slot = levelStart_[level]; slot < levelStart_[level + 1]; ++slot) {
+                const uint32_t i = levelOrder_[slot];
+                const uint32_t parent = levelOrderParent_[slot];
+                if (parent != kNoParent) {
+                    dirty_[i] |= dirty_[parent];
+                }
+                if (!dirty_[i]) {
+                    continue;
+                }
+
+                glm::mat4 local = glm::mat4_cast(rotations_[i]);
+                local[0] *= scales_[i].x;
+                local[1] *= scales_[i].y;
+                local[2] *= scales_[i].z;
+                local[3] = glm::vec4(positions_[i], 1.0f);
+                worldMatrices_[i] = parent == kNoParent ? local : worldMatrices_[parent] * local;
+
+                updateWorldBounds(i);
+                staticChanged_ = staticChanged_ || static_[i];
+                recordChange(denseToSlot_[i], AChangeJournal::TransformChanged);
+                if (bvh_.contains(denseToSlot_[i])) {
+                    bvh_.update(denseToSlot_[i], worldBoundsMin_[i], worldBoundsMax_[i]);
+                    ++bvhRefits_;
+                }
+                broadphase_.update(denseToSlot_[i], worldBoundsMin_[i], worldBoundsMax_[i]);
+                hashMoved_.push_back(i);
+            }
+        }
+
+        // A few movers are relinked one by one; when a large share moved, one parallel rebuild is cheaper.
+        if (hashMoved_.size() > std::max<size_t>(1024, getEntityCount() / 4)) {
+            rebuildSpatialHash();
+        } else {
+            for (uint32_t i : hashMoved_) {
+                spatialHash_.update(denseToSlot_[i], glm::vec3(worldMatrices_[i][3]));
+            }
+        }
+        hashMoved_.clear();
+
+        std::fill(dirty_.begin(), dirty_.end(), uint8_t{0});
+        anyDirty_ = false;
+    }
+
+    if (staticChanged_) {
+        rebuildStaticBatches();
+    }
+
+    // Linear tests on unindexed entities stay cheap while they are a small share of the world, and
+    // refitting keeps the tree valid but loosens it as things move; rebuild once either adds up.
+    const size_t rebuildThreshold = std::max<size_t>(64, getEntityCount() / 32);
+    if (unindexed_.size() > rebuildThreshold || bvhRefits_ > 4 * rebuildThreshold) {
+        rebuildBvh();
+    }
+}
+
+bool AWorld::isAlive(const AEntity& entity) const {
+    if (entity.getId() >= slots_.size()) {
+        return false;
+    }
+    const Slot& slot = slots_[entity.getId()];
+    return slot.alive && slot.generation == entity.getGeneration();
+}
+
+uint32_t AWorld::getIndex(const AEntity& entity) const {
+    assert(isAlive(entity));
+    return slots_[entity.getId()].dense;
+}
+
+AEntity AWorld::getEntity(uint32_t index) {
+    const uint32_t id = denseToSlot_[index];
+    return AEntity(this, id, slots_[id].generation);
+}
+
+void AWorld::setPosition(uint32_t index, const glm::vec3& position) {
+    positions_[index] = position;
+    markDirty(index);
+}
+
+void AWorld::setRotation(uint32_t index, const glm::quat& rotation) {
+    rotations_[index] = rotation;
+    markDirty(index);
+}
+
+void AWorld::setScale(uint32_t index, const glm::vec3& scale) {
+    scales_[index] = scale;
+    markDirty(index);
+}
+
+void AWorld::setMesh(uint32_t index, const AMesh& mesh) {
+    if (!isAlive(mesh)) {
+        return;
+    }
+    if (meshIds_[index] != mesh.getId()) {
+        recordChange(denseToSlot_[index], AChangeJournal::GeometryChanged);
+    }
+    assignMesh(index, mesh.getId());
+    // World bounds and the BVH follow on the next updateTransforms().
+    markDirty(index);
+}
+
+void AWorld::setVertices(uint32_t index, std::span<const glm::vec3> vertices) {
+    // Same vertex count keeps the current triangles and colors; any other count is taken as a
+    // new polygon. createMesh() copies the inputs before growing the pools.
+    const uint32_t meshId = meshIds_[index];
+    if (vertices.size() == meshes_[meshId].vertexCount) {
+        setMesh(index, createMesh(vertices, getMeshIndices(meshId), getMeshVertexColors(meshId)));
+        return;
+    }
+    setMesh(index, createMesh(vertices));
+}
+
+void AWorld::setColor(uint32_t index, const AEntity::Color& color) {
+    colors_[index] = color;
+    staticChanged_ = staticChanged_ || static_[index];
+    recordChange(denseToSlot_[index], AChangeJournal::ColorChanged);
+}
+
+void AWorld::setStatic(uint32_t index, bool isStatic) {
+    if (static_[index] != static_cast<uint8_t>(isStatic)) {
+        static_[index] = isStatic ? 1 : 0;
+        staticChanged_ = true;
+    }
+}
+
+void AWorld::rebuildStaticBatches() {
+    staticChanged_ = false;
+    for (const StaticBatch& batch : staticBatches_) {
+        pendingChanges_.releasedMeshKeys_.push_back(batch.key);
+    }
+    staticBatches_.clear();
+    staticVertices_.clear();
+    staticColors_.clear();
+    staticIndices_.clear();
+
+    // Morton order of the box centers over the static set's extent keeps each batch spatially
+    // compact, so batches still cull well.
+    glm::vec3 setMin(std::numeric_limits<float>::max());
+    glm::vec3 setMax(-std::numeric_limits<float>::max());
+    for (uint32_t i = 0; i < getEntityCount(); ++i) {
+        if (static_[i]) {
+            const glm::vec3 center = (worldBoundsMin_[i] + worldBoundsMax_[i]) * 0.5f;
+            setMin = glm::min(setMin, center);
+            setMax = glm::max(setMax, center);
+        }
+    }
+    const glm::vec3 scale = 1023.0f / glm::max(setMax - setMin, glm::vec3(1e-6f));
+    staticOrder_.clear();
+    for (uint32_t i = 0; i < getEntityCount(); ++i) {
+        if (static_[i]) {
+            const glm::vec3 cell = ((worldBoundsMin_[i] + worldBoundsMax_[i]) * 0.5f - setMin) * scale;
+            const uint32_t code = spreadBits(static_cast<uint32_t>(cell.x)) |
+                                  (spreadBits(static_cast<uint32_t>(cell.y)) << 1) |
+                                  (spreadBits(static_cast<uint32_t>(cell.z)) << 2);
+            staticOrder_.emplace_back(code, i);
+        }
+    }
+    std::sort(staticOrder_.begin(), staticOrder_.end());
+
+    StaticBatch* batch = nullptr;
+    for (const auto& [code, i] : staticOrder_) {
+        const MeshGeometry geometry = getMeshGeometry(meshIds_[i]);
+        const auto vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+        if (geometry.indices.empty()) {
+            continue;
+        }
+        if (!batch || batch->vertexCount + vertexCount > kStaticBatchVertices) {
+            StaticBatch next;
+            next.key = nextMeshKey();
+            next.firstVertex = static_cast<uint32_t>(staticVertices_.size());
+            next.firstIndex = static_cast<uint32_t>(staticIndices_.size());
+            next.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+            next.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+            staticBatches_.push_back(next);
+            batch = &staticBatches_.back();
+        }
+
+        const glm::mat4& m = worldMatrices_[i];
+        for (const glm::vec3& vertex : geometry.vertices) {
+            staticVertices_.push_back(glm::vec3(m * glm::vec4(vertex, 1.0f)));
+        }
+        // Colors are baked so one draw covers entities of every color.
+        if (meshes_[meshIds_[i]].hasVertexColors) {
+            staticColors_.insert(staticColors_.end(), geometry.vertexColors.begin(), geometry.vertexColors.end());
+        } else {
+            staticColors_.insert(staticColors_.end(), vertexCount, colors_[i]);
+        }
+        for (uint32_t index : geometry.indices) {
+            staticIndices_.push_back(batch->vertexCount + index);
+        }
+        batch->vertexCount += vertexCount;
+        batch->indexCount += static_cast<uint32_t>(geometry.indices.size());
+        ++batch->entityCount;
+        batch->boundsMin = glm::min(batch->boundsMin, worldBoundsMin_[i]);
+        batch->boundsMax = glm::max(batch->boundsMax, worldBoundsMax_[i]);
+    }
+}
+
+AWorld::MeshGeometry AWorld::getStaticBatchGeometry(uint32_t batch) const {
+    const StaticBatch& range = staticBatches_[batch];
+    MeshGeometry geometry;
+    geometry.vertices = std::span<const glm::vec3>(staticVertices_).subspan(range.firstVertex, range.vertexCount);
+    geometry.vertexColors = std::span<const AEntity::Color>(staticColors_).subspan(range.firstVertex, range.vertexCount);
+    geometry.indices = std::span<const uint32_t>(staticIndices_).subspan(range.firstIndex, range.indexCount);
+    return geometry;
+}
+
+void AWorld::setVertexColors(uint32_t index, const std::vector<AEntity::Color>& colors) {
+    const uint32_t meshId = meshIds_[index];
+    const auto vertices = getMeshVertices(meshId);
+    const auto indices = getMeshIndices(meshId);
+    if (colors.size() != vertices.size()) {
+        setMesh(index, createMesh(vertices, indices));
+        return;
+    }
+    setMesh(index, createMesh(vertices, indices, colors));
+}
+
+std::span<const glm::vec3> AWorld::getMeshVertices(uint32_t meshId) const {
+    return getMeshGeometry(meshId).vertices;
+}
+
+std::span<const uint32_t> AWorld::getMeshIndices(uint32_t meshId) const {
+    return getMeshGeometry(meshId).indices;
+}
+
+std::span<const AEntity::Color> AWorld::getMeshVertexColors(uint32_t meshId) const {
+    return getMeshGeometry(meshId).vertexColors;
+}
+
+AWorld::MeshGeometry AWorld::getMeshGeometry(uint32_t meshId, uint32_t lod) const {
+    const MeshData& mesh = meshes_[meshId];
+    const MeshLod& range = mesh.lods[lod];
+    std::span<const glm::vec3> vertices = vertexPool_;
+    std::span<const AEntity::Color> colors = vertexColorPool_;
+    std::span<const uint32_t> indices = indexPool_;
+    if (mesh.source != 0) {
+        const ASceneFile& scene = *scenes_[mesh.source - 1];
+        vertices = scene.getVertices();
+        colors = scene.getVertexColors();
+        indices = scene.getIndices();
+    }
+    MeshGeometry geometry;
+    geometry.vertices = vertices.subspan(range.firstVertex, range.vertexCount);
+    geometry.indices = indices.subspan(range.firstIndex, range.indexCount);
+    if (mesh.hasVertexColors) {
+        geometry.vertexColors = colors.subspan(range.firstVertex, range.vertexCount);
+    }
+    return geometry;
+}
+
+AFloatingText& AWorld::addFloatingText(const AFloatingText& text) {
+    floatingTexts_.push_back(floatingTextPool_.make(text));
+    AFloatingText& added = *floatingTexts_.back();
+    added.world_ = this;
+    markTextsChanged();
+    return added;
+}
+
+const std::vector<AObjectPool<AFloatingText>::Pointer>& AWorld::getFloatingTexts() const {
     return floatingTexts_;
 }
+
+AParticleSystem& AWorld::addParticleSystem(uint32_t capacity) {
+    particleSystems_.push_back(std::make_unique<AParticleSystem>(capacity));
+    return *particleSystems_.back();
+}
+
+void AWorld::destroyParticleSystem(const AParticleSystem* system) {
+    if (system) {
+        pendingParticleRemovals_.push_back(system);
+    }
+}
+
+void AWorld::updateParticles(float deltaTime) {
+    for (const auto& system : particleSystems_) {
+        system->update(deltaTime);
+    }
+}
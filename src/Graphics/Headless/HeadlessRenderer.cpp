@@ -0,0 +1,52 @@
+#include "HeadlessRenderer.h"
+
+HeadlessRenderer::HeadlessRenderer() = default;
+
+HeadlessRenderer::~HeadlessRenderer() {
+    shutdown();
+}
+
+bool HeadlessRenderer::initialize(void* nativeWindow, int width, int height) {
+    (void)nativeWindow;
+    resize(width, height);
+    return true;
+}
+
+void HeadlessRenderer::shutdown() {
+    rasterizer_.releaseTarget();
+    colorBuffer_.clear();
+    colorBuffer_.shrink_to_fit();
+    width_ = 0;
+    height_ = 0;
+}
+
+void HeadlessRenderer::resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    if (width_ <= 0 || height_ <= 0) {
+        rasterizer_.releaseTarget();
+        colorBuffer_.clear();
+        return;
+    }
+    colorBuffer_.assign(static_cast<size_t>(width_) * static_cast<size_t>(height_) * 4, 0);
+    rasterizer_.setTarget(colorBuffer_.data(), width_ * 4, width_, height_);
+}
+
+void HeadlessRenderer::draw(const ARenderCommandList& commands) {
+    if (!rasterizer_.hasTarget()) {
+        return;
+    }
+
+    rasterizer_.clear();
+    rasterizer_.draw(commands);
+}
+
+bool HeadlessRenderer::readPixels(std::vector<uint8_t>& outBgra, int& outWidth, int& outHeight) const {
+    if (colorBuffer_.empty()) {
+        return false;
+    }
+    outBgra = colorBuffer_;
+    outWidth = width_;
+    outHeight = height_;
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Graphics/IRendererImpl.h>
+#include <Graphics/Software/SoftwareRasterizer.h>
+#include <cstdint>
+#include <vector>
+
+// Headless renderer: runs the shared software rasterizer into a plain memory buffer and never
+// touches a window system. Text commands are skipped since glyphs come from GDI on the other
+// software backends.
+class HeadlessRenderer : public IRendererImpl {
+public:
+    HeadlessRenderer();
+    ~HeadlessRenderer() override;
+
+    bool initialize(void* nativeWindow, int width, int height) override;
+    void shutdown() override;
+    void resize(int width, int height) override;
+    void draw(const ARenderCommandList& commands) override;
+    bool readPixels(std::vector<uint8_t>& outBgra, int& outWidth, int& outHeight) const override;
+
+private:
+    int width_{0};
+    int height_{0};
+    std::vector<uint8_t> colorBuffer_;
+    SoftwareRasterizer rasterizer_;
+};
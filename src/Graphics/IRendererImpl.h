@@ -1,7 +1,9 @@
 #pragma once
 
-#include <AViewport>
+#include <ARenderCommandList>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 class IRendererImpl {
 public:
@@ -10,6 +12,21 @@ public:
     virtual bool initialize(void* nativeWindow, int width, int height) = 0;
     virtual void shutdown() = 0;
     virtual void resize(int width, int height) = 0;
-    virtual void draw(const AViewport& viewport) = 0;
-    virtual void setWorld(class AWorld* world) = 0;
+    // Replays a recorded command list into the back buffer and presents it.
+    virtual void draw(const ARenderCommandList& commands) = 0;
+
+    // Most recent GPU execution time of a frame. Results are read back with a few frames of
+    // latency; returns false when the backend has no GPU timing or no result is ready yet.
+    virtual bool getGpuTime(double& outMilliseconds) const {
+        (void)outMilliseconds;
+        return false;
+    }
+
+    // Copies the last frame as top-down BGRA8; only backends that render into memory support it.
+    virtual bool readPixels(std::vector<uint8_t>& outBgra, int& outWidth, int& outHeight) const {
+        (void)outBgra;
+        (void)outWidth;
+        (void)outHeight;
+        return false;
+    }
 };
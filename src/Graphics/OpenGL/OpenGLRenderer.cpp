@@ -1,10 +1,7 @@
 #include "OpenGLRenderer.h"
 
-#include <glm/gtc/matrix_transform.hpp>
+#include <AWorld>
 #include <glm/gtc/type_ptr.hpp>
-#include <ARenderOverlay>
-#include <AText>
-#include <AFloatingText>
 #include <algorithm>
 #include <cassert>
 #include <string>
@@ -12,18 +9,21 @@
 
 namespace {
 
-bool projectToScreen(const glm::vec3& world, const glm::mat4& view, const glm::mat4& projection, int width, int height, POINT& out) {
-    glm::vec4 clip = projection * view * glm::vec4(world, 1.0f);
-    if (clip.w <= 0.0f) {
-        return false;
-    }
-    glm::vec3 ndc = glm::vec3(clip) / clip.w;
-    if (ndc.z < -1.0f || ndc.z > 1.0f) {
-        return false;
+// Not exposed by the legacy gl/GL.h header shipped with Windows.
+constexpr GLenum kGlTimeElapsed = 0x88BF;
+constexpr GLenum kGlQueryResult = 0x8866;
+constexpr GLenum kGlQueryResultAvailable = 0x8867;
+
+template <typename Fn>
+Fn loadGlFunction(const char* name) {
+    // wglGetProcAddress may return small sentinel values instead of null on failure.
+    PROC proc = wglGetProcAddress(name);
+    const auto address = reinterpret_cast<intptr_t>(proc);
+    if (address == 0 || address == 1 || address == 2 || address == 3 || address == -1) {
+        return nullptr;
     }
-    out.x = static_cast<int>((ndc.x * 0.5f + 0.5f) * static_cast<float>(width));
-    out.y = static_cast<int>((1.0f - (ndc.y * 0.5f + 0.5f)) * static_cast<float>(height));
-    return true;
+    // Through a generic function pointer so MinGW's -Wcast-function-type stays quiet.
+    return reinterpret_cast<Fn>(reinterpret_cast<void (*)()>(proc));
 }
 
 } // namespace
@@ -38,13 +38,22 @@ bool OpenGLRenderer::initialize(void* nativeWindow, int width, int height) {
     hwnd_ = static_cast<HWND>(nativeWindow);
     width_ = width;
     height_ = height;
+    if (!hwnd_) {
+        return false; // Offscreen windows have no device context to render into.
+    }
 
     setupContext(hwnd_);
     setupState();
+    setupTimerQueries();
+    // Release the context so the first draw can bind it on whichever thread renders (see AFramePipeline).
+    wglMakeCurrent(nullptr, nullptr);
     return true;
 }
 
 void OpenGLRenderer::shutdown() {
+    releaseTimerQueries();
+    releaseMeshLists();
+
     if (hglrc_ && !fontCache_.empty()) {
         wglMakeCurrent(hdc_, hglrc_);
         for (const auto& entry : fontCache_) {
@@ -76,38 +85,136 @@ void OpenGLRenderer::resize(int width, int height) {
     if (hdc_ && hglrc_) {
         wglMakeCurrent(hdc_, hglrc_);
         glViewport(0, 0, width_, height_);
+        wglMakeCurrent(nullptr, nullptr);
     }
 }
 
-void OpenGLRenderer::draw(const AViewport& viewport) {
+void OpenGLRenderer::draw(const ARenderCommandList& commands) {
     if (!hdc_ || !hglrc_) {
         return;
     }
 
-    if (width_ != viewport.getWidth() || height_ != viewport.getHeight()) {
-        resize(viewport.getWidth(), viewport.getHeight());
-    }
-
     wglMakeCurrent(hdc_, hglrc_);
+    applyWorldChanges(commands);
+    beginTimerQuery();
     glViewport(0, 0, width_, height_);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    if (world_) {
-        const glm::mat4& view = viewport.getViewMatrix();
-        const glm::mat4& projection = viewport.getProjectionMatrix();
-
-        for (const auto& entityPtr : world_->getEntities()) {
-            drawEntity(*entityPtr, view, projection);
+    const ARenderCommandList::View* view = nullptr;
+    for (const auto& command : commands.getCommands()) {
+        switch (command.type) {
+        case ARenderCommandList::Type::SetView:
+            view = &commands.getView(command.index);
+            glViewport(view->x, height_ - view->y - view->height, view->width, view->height);
+            glMatrixMode(GL_PROJECTION);
+            glLoadMatrixf(glm::value_ptr(view->projection));
+            break;
+        case ARenderCommandList::Type::DrawMesh:
+            if (view) {
+                drawMesh(commands, commands.getMesh(command.index), view->view);
+            }
+            break;
+        case ARenderCommandList::Type::DrawInstances:
+            if (view) {
+                drawInstances(commands, commands.getMesh(command.index), view->view);
+            }
+            break;
+        case ARenderCommandList::Type::DrawSprites:
+            if (view) {
+                drawSprites(commands, commands.getSpriteBatch(command.index), view->view);
+            }
+            break;
+        default:
+            break;
         }
     }
 
     // Draw overlay into the back buffer using OpenGL so it is stable across swaps.
-    drawOverlayText(viewport);
+    drawOverlayText(commands);
+    endTimerQuery();
+    evictMeshLists();
+    ++frame_;
     SwapBuffers(hdc_);
+    wglMakeCurrent(nullptr, nullptr);
 }
 
-void OpenGLRenderer::setWorld(AWorld* world) {
-    world_ = world;
+bool OpenGLRenderer::getGpuTime(double& outMilliseconds) const {
+    if (!hasGpuTime_) {
+        return false;
+    }
+    outMilliseconds = lastGpuTimeMs_;
+    return true;
+}
+
+void OpenGLRenderer::setupTimerQueries() {
+    glGenQueries_ = loadGlFunction<GenQueriesFn>("glGenQueries");
+    glDeleteQueries_ = loadGlFunction<DeleteQueriesFn>("glDeleteQueries");
+    glBeginQuery_ = loadGlFunction<BeginQueryFn>("glBeginQuery");
+    glEndQuery_ = loadGlFunction<EndQueryFn>("glEndQuery");
+    glGetQueryObjectiv_ = loadGlFunction<GetQueryObjectivFn>("glGetQueryObjectiv");
+    glGetQueryObjectui64v_ = loadGlFunction<GetQueryObjectui64vFn>("glGetQueryObjectui64v");
+
+    timerQueriesAvailable_ = glGenQueries_ && glDeleteQueries_ && glBeginQuery_ && glEndQuery_ &&
+                             glGetQueryObjectiv_ && glGetQueryObjectui64v_;
+    if (!timerQueriesAvailable_) {
+        return;
+    }
+    glGenQueries_(static_cast<GLsizei>(timerQueries_.size()), timerQueries_.data());
+    timerQueryPending_.fill(false);
+    timerQueryWrite_ = 0;
+}
+
+void OpenGLRenderer::releaseTimerQueries() {
+    if (timerQueriesAvailable_ && hdc_ && hglrc_) {
+        wglMakeCurrent(hdc_, hglrc_);
+        glDeleteQueries_(static_cast<GLsizei>(timerQueries_.size()), timerQueries_.data());
+    }
+    timerQueries_.fill(0);
+    timerQueryPending_.fill(false);
+    timerQueriesAvailable_ = false;
+    timerQueryActive_ = false;
+    hasGpuTime_ = false;
+}
+
+void OpenGLRenderer::beginTimerQuery() {
+    if (!timerQueriesAvailable_) {
+        return;
+    }
+
+    // Collect every finished result, oldest first, so the reported time is the latest available.
+    for (size_t i = 0; i < kTimerQueryCount; ++i) {
+        const size_t slot = (timerQueryWrite_ + i) % kTimerQueryCount;
+        if (!timerQueryPending_[slot]) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv_(timerQueries_[slot], kGlQueryResultAvailable, &available);
+        if (!available) {
+            continue;
+        }
+        uint64_t elapsedNs = 0;
+        glGetQueryObjectui64v_(timerQueries_[slot], kGlQueryResult, &elapsedNs);
+        timerQueryPending_[slot] = false;
+        lastGpuTimeMs_ = static_cast<double>(elapsedNs) / 1.0e6;
+        hasGpuTime_ = true;
+    }
+
+    // Every query still in flight: skip timing this frame rather than block on the oldest one.
+    if (timerQueryPending_[timerQueryWrite_]) {
+        return;
+    }
+    glBeginQuery_(kGlTimeElapsed, timerQueries_[timerQueryWrite_]);
+    timerQueryActive_ = true;
+}
+
+void OpenGLRenderer::endTimerQuery() {
+    if (!timerQueryActive_) {
+        return;
+    }
+    glEndQuery_(kGlTimeElapsed);
+    timerQueryPending_[timerQueryWrite_] = true;
+    timerQueryWrite_ = (timerQueryWrite_ + 1) % kTimerQueryCount;
+    timerQueryActive_ = false;
 }
 
 void OpenGLRenderer::setupContext(HWND hwnd) {
@@ -140,38 +247,160 @@ void OpenGLRenderer::setupState() {
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
-void OpenGLRenderer::drawEntity(const AEntity& entity, const glm::mat4& view, const glm::mat4& projection) {
-    const auto& vertices = entity.getVertices();
-    if (vertices.empty()) {
+void OpenGLRenderer::drawMesh(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh, const glm::mat4& view) {
+    if (mesh.indexCount < 3) {
         return;
     }
-    const auto& vertexColors = entity.getVertexColors();
-    const bool hasPerVertexColors = vertexColors.size() == vertices.size();
 
-    const glm::mat4 model = glm::translate(glm::mat4(1.0f), entity.getPosition());
+    glMatrixMode(GL_MODELVIEW);
+    const glm::mat4 viewModel = view * mesh.model;
+    glLoadMatrixf(glm::value_ptr(viewModel));
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadMatrixf(glm::value_ptr(projection));
+    // Without vertex colors the geometry is shared by entities of different colors,
+    // so the color is set per draw and the list (or direct path) leaves it alone.
+    if (!mesh.hasVertexColors) {
+        glColor4f(mesh.color.r, mesh.color.g, mesh.color.b, mesh.color.a);
+    }
+
+    if (mesh.meshKey != 0) {
+        if (const GLuint list = getMeshList(commands, mesh)) {
+            glCallList(list);
+            return;
+        }
+    }
+    drawElements(commands, mesh);
+}
+
+void OpenGLRenderer::drawInstances(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh, const glm::mat4& view) {
+    if (mesh.indexCount < 3) {
+        return;
+    }
 
+    // The fixed-function pipeline has no instanced draw, so the geometry is resolved once (as a
+    // display list when shared) and each instance only changes the matrix and color.
+    const GLuint list = mesh.meshKey != 0 ? getMeshList(commands, mesh) : 0;
+    const AInstance* instances = commands.getInstances().data() + mesh.firstInstance;
     glMatrixMode(GL_MODELVIEW);
-    const glm::mat4 viewModel = view * model;
-    glLoadMatrixf(glm::value_ptr(viewModel));
+    for (uint32_t i = 0; i < mesh.instanceCount; ++i) {
+        const glm::mat4 viewModel = view * instances[i].transform;
+        glLoadMatrixf(glm::value_ptr(viewModel));
+        if (!mesh.hasVertexColors) {
+            const AEntity::Color& color = instances[i].color;
+            glColor4f(color.r, color.g, color.b, color.a);
+        }
+        if (list) {
+            glCallList(list);
+        } else {
+            drawElements(commands, mesh);
+        }
+    }
+}
 
-    const auto color = entity.getColor();
+void OpenGLRenderer::drawElements(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh) {
+    // Indexed vertex arrays let the driver's post-transform cache reuse shared vertices, which
+    // immediate mode cannot.
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(glm::vec3), commands.getVertices().data() + mesh.firstVertex);
+    if (mesh.hasVertexColors) {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_FLOAT, sizeof(AEntity::Color), commands.getVertexColors().data() + mesh.firstVertex);
+    }
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.indexCount), GL_UNSIGNED_INT, commands.getIndices().data() + mesh.firstIndex);
+    if (mesh.hasVertexColors) {
+        glDisableClientState(GL_COLOR_ARRAY);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
 
-    GLenum primitive = vertices.size() == 3 ? GL_TRIANGLES : GL_TRIANGLE_FAN;
-    glBegin(primitive);
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        if (hasPerVertexColors) {
-            const auto& c = vertexColors[i];
-            glColor4f(c.r, c.g, c.b, c.a);
+void OpenGLRenderer::drawSprites(const ARenderCommandList& commands, const ARenderCommandList::SpriteBatch& batch, const glm::mat4& view) {
+    // Fixed-function point sprites cannot vary in size per point, so each sprite becomes a quad
+    // spanned by the camera's right and up axes, and the whole batch goes out in one draw.
+    const glm::vec3 right(view[0][0], view[1][0], view[2][0]);
+    const glm::vec3 up(view[0][1], view[1][1], view[2][1]);
+    const ARenderCommandList::Sprite* sprites = commands.getSprites().data() + batch.firstSprite;
+    spriteVertices_.resize(static_cast<size_t>(batch.spriteCount) * 4);
+    spriteColors_.resize(spriteVertices_.size());
+    for (uint32_t i = 0; i < batch.spriteCount; ++i) {
+        const ARenderCommandList::Sprite& sprite = sprites[i];
+        const glm::vec3 r = right * (0.5f * sprite.size);
+        const glm::vec3 u = up * (0.5f * sprite.size);
+        glm::vec3* quad = spriteVertices_.data() + static_cast<size_t>(i) * 4;
+        quad[0] = sprite.position - r - u;
+        quad[1] = sprite.position + r - u;
+        quad[2] = sprite.position + r + u;
+        quad[3] = sprite.position - r + u;
+        std::fill_n(spriteColors_.data() + static_cast<size_t>(i) * 4, 4, sprite.color);
+    }
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(glm::value_ptr(view));
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(glm::vec3), spriteVertices_.data());
+    glColorPointer(4, GL_FLOAT, sizeof(AEntity::Color), spriteColors_.data());
+    glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(spriteVertices_.size()));
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+GLuint OpenGLRenderer::getMeshList(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh) {
+    auto it = meshLists_.find(mesh.meshKey);
+    if (it != meshLists_.end()) {
+        it->second.lastUsedFrame = frame_;
+        return it->second.list;
+    }
+
+    const GLuint list = glGenLists(1);
+    if (list == 0) {
+        return 0;
+    }
+    // Array contents are captured when the list is compiled, so the command list may go away.
+    glNewList(list, GL_COMPILE);
+    drawElements(commands, mesh);
+    glEndList();
+    meshLists_.emplace(mesh.meshKey, MeshListEntry{list, frame_});
+    return list;
+}
+
+void OpenGLRenderer::applyWorldChanges(const ARenderCommandList& commands) {
+    // Released meshes never come back under the same key, so their lists go now rather than
+    // lingering until the idle sweep.
+    for (const AChangeJournal& changes : commands.getWorldChanges()) {
+        for (const uint64_t key : changes.getReleasedMeshKeys()) {
+            for (uint32_t level = 0; level < AWorld::kMaxMeshLods; ++level) {
+                auto it = meshLists_.find(ARenderCommandList::makeMeshKey(key, level));
+                if (it != meshLists_.end()) {
+                    glDeleteLists(it->second.list, 1);
+                    meshLists_.erase(it);
+                }
+            }
+        }
+    }
+}
+
+void OpenGLRenderer::evictMeshLists() {
+    // Sweep occasionally for lists nobody draws anymore, e.g. LOD levels the camera moved away from.
+    if (frame_ % 64 != 0) {
+        return;
+    }
+    for (auto it = meshLists_.begin(); it != meshLists_.end();) {
+        if (frame_ - it->second.lastUsedFrame > kMeshListIdleFrames) {
+            glDeleteLists(it->second.list, 1);
+            it = meshLists_.erase(it);
         } else {
-            glColor4f(color.r, color.g, color.b, color.a);
+            ++it;
+        }
+    }
+}
+
+void OpenGLRenderer::releaseMeshLists() {
+    if (hglrc_ && !meshLists_.empty()) {
+        wglMakeCurrent(hdc_, hglrc_);
+        for (const auto& [key, entry] : meshLists_) {
+            glDeleteLists(entry.list, 1);
         }
-        const auto& v = vertices[i];
-        glVertex3f(v.x, v.y, v.z);
     }
-    glEnd();
+    meshLists_.clear();
 }
 
 GLuint OpenGLRenderer::getFontBase(int pixelHeight, HFONT& outFont) {
@@ -219,71 +448,15 @@ int OpenGLRenderer::measureTextWidth(const std::string& text, HFONT font) const
     return static_cast<int>(extent.cx);
 }
 
-void OpenGLRenderer::drawOverlayText(const AViewport& viewport) {
+void OpenGLRenderer::drawOverlayText(const ARenderCommandList& commands) {
     if (!hdc_ || !hglrc_) {
         return;
     }
 
-    struct ResolvedText {
-        std::string text;
-        int x{0};
-        int y{0};
-        bool alignRight{false};
-        int pixelHeight{16};
-        AEntity::Color color{};
-    };
-
-    std::vector<ResolvedText> resolved;
-
-    auto appendScreenText = [&](const AText& text) {
-        resolved.push_back(ResolvedText{
-            text.getText(),
-            text.getPosition().x,
-            text.getPosition().y,
-            text.isAlignRight(),
-            text.getPixelHeight(),
-            text.getColor()
-        });
-    };
-
-    auto appendFloatingText = [&](const AFloatingText& text) {
-        POINT screen{};
-        if (!projectToScreen(text.getWorldPosition(), viewport.getViewMatrix(), viewport.getProjectionMatrix(), width_, height_, screen)) {
-            return;
-        }
-        resolved.push_back(ResolvedText{
-            text.getText(),
-            screen.x,
-            screen.y,
-            false,
-            text.getPixelHeight(),
-            text.getColor()
-        });
-    };
-
-    for (const auto* overlay : viewport.getOverlays()) {
-        if (!overlay) {
-            continue;
-        }
-        for (const auto& text : overlay->getTexts()) {
-            if (text) {
-                appendScreenText(*text);
-            }
-        }
-        for (const auto& floating : overlay->getFloatingTexts()) {
-            if (floating) {
-                appendFloatingText(*floating);
-            }
-        }
-    }
-
-    if (auto* world = viewport.getWorld()) {
-        for (const auto& floating : world->getFloatingTexts()) {
-            appendFloatingText(*floating);
-        }
-    }
-
-    if (resolved.empty()) {
+    const bool hasText = std::any_of(commands.getCommands().begin(), commands.getCommands().end(), [](const auto& command) {
+        return command.type == ARenderCommandList::Type::DrawText;
+    });
+    if (!hasText) {
         return;
     }
 
@@ -293,6 +466,8 @@ void OpenGLRenderer::drawOverlayText(const AViewport& viewport) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    // Text positions are window-relative, so cover the whole surface regardless of the last view.
+    glViewport(0, 0, width_, height_);
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
     glLoadIdentity();
@@ -302,7 +477,17 @@ void OpenGLRenderer::drawOverlayText(const AViewport& viewport) {
     glPushMatrix();
     glLoadIdentity();
 
-    for (const auto& overlay : resolved) {
+    const ARenderCommandList::View* view = nullptr;
+    for (const auto& command : commands.getCommands()) {
+        if (command.type == ARenderCommandList::Type::SetView) {
+            view = &commands.getView(command.index);
+            continue;
+        }
+        if (command.type != ARenderCommandList::Type::DrawText || !view) {
+            continue;
+        }
+
+        const auto& overlay = commands.getText(command.index);
         HFONT fontHandle = nullptr;
         GLuint base = getFontBase(overlay.pixelHeight, fontHandle);
         if (base == 0 || !fontHandle) {
@@ -310,11 +495,11 @@ void OpenGLRenderer::drawOverlayText(const AViewport& viewport) {
         }
 
         int textWidth = measureTextWidth(overlay.text, fontHandle);
-        int x = overlay.alignRight ? (width_ - overlay.x - textWidth) : overlay.x;
+        int x = overlay.alignRight ? (view->width - overlay.x - textWidth) : overlay.x;
         int y = overlay.y + overlay.pixelHeight; // baseline adjustment for top-left origin
 
         glColor4f(overlay.color.r, overlay.color.g, overlay.color.b, overlay.color.a);
-        glRasterPos2i(x, y);
+        glRasterPos2i(view->x + x, view->y + y);
         glListBase(base);
         glCallLists(static_cast<GLsizei>(overlay.text.size()), GL_UNSIGNED_BYTE, overlay.text.c_str());
     }
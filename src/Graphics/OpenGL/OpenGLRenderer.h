@@ -6,7 +6,9 @@
 #endif
 #include <Windows.h>
 #include <gl/GL.h>
-#include <AWorld>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -18,14 +20,26 @@ public:
     bool initialize(void* nativeWindow, int width, int height) override;
     void shutdown() override;
     void resize(int width, int height) override;
-    void draw(const AViewport& viewport) override;
-    void setWorld(AWorld* world) override;
+    void draw(const ARenderCommandList& commands) override;
+    bool getGpuTime(double& outMilliseconds) const override;
 
 private:
     void setupContext(HWND hwnd);
     void setupState();
-    void drawEntity(const AEntity& entity, const glm::mat4& view, const glm::mat4& projection);
-    void drawOverlayText(const AViewport& viewport);
+    void setupTimerQueries();
+    void releaseTimerQueries();
+    void beginTimerQuery();
+    void endTimerQuery();
+    void drawMesh(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh, const glm::mat4& view);
+    void drawInstances(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh, const glm::mat4& view);
+    void drawElements(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh);
+    void drawSprites(const ARenderCommandList& commands, const ARenderCommandList::SpriteBatch& batch, const glm::mat4& view);
+    GLuint getMeshList(const ARenderCommandList& commands, const ARenderCommandList::Mesh& mesh);
+    // Drops display lists of meshes the worlds released since the previous frame.
+    void applyWorldChanges(const ARenderCommandList& commands);
+    void evictMeshLists();
+    void releaseMeshLists();
+    void drawOverlayText(const ARenderCommandList& commands);
     GLuint getFontBase(int pixelHeight, HFONT& outFont);
     int measureTextWidth(const std::string& text, HFONT font) const;
 
@@ -34,7 +48,6 @@ private:
     HGLRC hglrc_{nullptr};
     int width_{0};
     int height_{0};
-    AWorld* world_{nullptr};
 
     struct FontEntry {
         int size{0};
@@ -42,4 +55,42 @@ private:
         HFONT font{nullptr};
     };
     std::vector<FontEntry> fontCache_;
+
+    // Shared world meshes compiled once into display lists, keyed by ARenderCommandList::Mesh::meshKey.
+    // Keys are never reused, so an entry only goes stale by not being drawn for a while.
+    struct MeshListEntry {
+        GLuint list{0};
+        uint64_t lastUsedFrame{0};
+    };
+    static constexpr uint64_t kMeshListIdleFrames = 300;
+    std::unordered_map<uint64_t, MeshListEntry> meshLists_;
+    uint64_t frame_{0};
+
+    // Sprite quads expanded per batch, reused across frames.
+    std::vector<glm::vec3> spriteVertices_;
+    std::vector<AEntity::Color> spriteColors_;
+
+    // GL_TIME_ELAPSED queries (GL 3.3 / ARB_timer_query) used as a small ring so results can be
+    // read back a few frames later without stalling the pipeline.
+    using GenQueriesFn = void(APIENTRY*)(GLsizei, GLuint*);
+    using DeleteQueriesFn = void(APIENTRY*)(GLsizei, const GLuint*);
+    using BeginQueryFn = void(APIENTRY*)(GLenum, GLuint);
+    using EndQueryFn = void(APIENTRY*)(GLenum);
+    using GetQueryObjectivFn = void(APIENTRY*)(GLuint, GLenum, GLint*);
+    using GetQueryObjectui64vFn = void(APIENTRY*)(GLuint, GLenum, uint64_t*);
+
+    static constexpr size_t kTimerQueryCount = 4;
+    GenQueriesFn glGenQueries_{nullptr};
+    DeleteQueriesFn glDeleteQueries_{nullptr};
+    BeginQueryFn glBeginQuery_{nullptr};
+    EndQueryFn glEndQuery_{nullptr};
+    GetQueryObjectivFn glGetQueryObjectiv_{nullptr};
+    GetQueryObjectui64vFn glGetQueryObjectui64v_{nullptr};
+    std::array<GLuint, kTimerQueryCount> timerQueries_{};
+    std::array<bool, kTimerQueryCount> timerQueryPending_{};
+    size_t timerQueryWrite_{0};
+    bool timerQueryActive_{false};
+    bool timerQueriesAvailable_{false};
+    bool hasGpuTime_{false};
+    double lastGpuTimeMs_{0.0};
 };
@@ -0,0 +1,389 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+enum class ClipPlane {
+    Left, Right, Bottom, Top, Near, Far
+};
+
+template <typename Vertex>
+Vertex interpolateClip(const Vertex& a, const Vertex& b, float t) {
+    Vertex out;
+    out.pos = a.pos + t * (b.pos - a.pos);
+    out.color.r = a.color.r + t * (b.color.r - a.color.r);
+    out.color.g = a.color.g + t * (b.color.g - a.color.g);
+    out.color.b = a.color.b + t * (b.color.b - a.color.b);
+    out.color.a = a.color.a + t * (b.color.a - a.color.a);
+    return out;
+}
+
+bool inside(const glm::vec4& pos, ClipPlane plane) {
+    switch (plane) {
+    case ClipPlane::Left:   return pos.x >= -pos.w;
+    case ClipPlane::Right:  return pos.x <=  pos.w;
+    case ClipPlane::Bottom: return pos.y >= -pos.w;
+    case ClipPlane::Top:    return pos.y <=  pos.w;
+    case ClipPlane::Near:   return pos.z >= -pos.w;
+    case ClipPlane::Far:    return pos.z <=  pos.w;
+    default: return false;
+    }
+}
+
+float computeT(const glm::vec4& a, const glm::vec4& b, ClipPlane plane) {
+    auto safeDiv = [](float num, float den) {
+        if (std::abs(den) < 1e-6f) {
+            return 0.0f;
+        }
+        float t = num / den;
+        return std::clamp(t, 0.0f, 1.0f);
+    };
+    switch (plane) {
+    case ClipPlane::Left:   return safeDiv((-(a.w + a.x)), ((b.w - a.w) + (b.x - a.x)));
+    case ClipPlane::Right:  return safeDiv((a.w - a.x),     ((b.w - a.w) - (b.x - a.x)));
+    case ClipPlane::Bottom: return safeDiv((-(a.w + a.y)), ((b.w - a.w) + (b.y - a.y)));
+    case ClipPlane::Top:    return safeDiv((a.w - a.y),     ((b.w - a.w) - (b.y - a.y)));
+    case ClipPlane::Near:   return safeDiv((-(a.w + a.z)), ((b.w - a.w) + (b.z - a.z)));
+    case ClipPlane::Far:    return safeDiv((a.w - a.z),     ((b.w - a.w) - (b.z - a.z)));
+    default: return 0.0f;
+    }
+}
+
+// One bit per ClipPlane the position lies outside of.
+uint8_t computeOutcode(const glm::vec4& pos) {
+    uint8_t code = 0;
+    code |= pos.x < -pos.w ? 0x01 : 0;
+    code |= pos.x >  pos.w ? 0x02 : 0;
+    code |= pos.y < -pos.w ? 0x04 : 0;
+    code |= pos.y >  pos.w ? 0x08 : 0;
+    code |= pos.z < -pos.w ? 0x10 : 0;
+    code |= pos.z >  pos.w ? 0x20 : 0;
+    return code;
+}
+
+// Clipping a convex polygon against one plane adds at most one vertex, so a triangle clipped by
+// all six planes never exceeds this.
+constexpr size_t kMaxClipVertices = 9;
+
+// Writes the clipped polygon to `out` (room for count + 1 vertices) and returns its vertex count.
+template <typename Vertex>
+size_t clipPolygon(const Vertex* input, size_t count, ClipPlane plane, Vertex* out) {
+    size_t outCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Vertex& current = input[i];
+        const Vertex& next = input[(i + 1) % count];
+        const bool currentInside = inside(current.pos, plane);
+        const bool nextInside = inside(next.pos, plane);
+
+        if (currentInside && nextInside) {
+            out[outCount++] = next;
+        } else if (currentInside && !nextInside) {
+            float t = computeT(current.pos, next.pos, plane);
+            out[outCount++] = interpolateClip(current, next, t);
+        } else if (!currentInside && nextInside) {
+            float t = computeT(current.pos, next.pos, plane);
+            out[outCount++] = interpolateClip(current, next, t);
+            out[outCount++] = next;
+        }
+    }
+    return outCount;
+}
+
+} // namespace
+
+void SoftwareRasterizer::setTarget(uint8_t* colorBits, int colorStride, int width, int height) {
+    colorBits_ = colorBits;
+    colorStride_ = colorStride;
+    width_ = width;
+    height_ = height;
+    if (colorBits_ && width_ > 0 && height_ > 0) {
+        depthBuffer_.assign(static_cast<size_t>(width_) * static_cast<size_t>(height_), 1.0f);
+    } else {
+        depthBuffer_.clear();
+    }
+}
+
+void SoftwareRasterizer::releaseTarget() {
+    colorBits_ = nullptr;
+    colorStride_ = 0;
+    width_ = 0;
+    height_ = 0;
+    depthBuffer_.clear();
+}
+
+bool SoftwareRasterizer::hasTarget() const {
+    return colorBits_ && !depthBuffer_.empty();
+}
+
+void SoftwareRasterizer::clear() {
+    if (!hasTarget()) {
+        return;
+    }
+    std::memset(colorBits_, 0, static_cast<size_t>(colorStride_) * static_cast<size_t>(height_));
+    std::fill(depthBuffer_.begin(), depthBuffer_.end(), 1.0f);
+}
+
+void SoftwareRasterizer::draw(const ARenderCommandList& commands) {
+    if (!hasTarget()) {
+        return;
+    }
+
+    const ARenderCommandList::View* view = nullptr;
+    glm::mat4 viewProjection{1.0f};
+    for (const auto& command : commands.getCommands()) {
+        switch (command.type) {
+        case ARenderCommandList::Type::SetView:
+            view = &commands.getView(command.index);
+            viewProjection = view->projection * view->view;
+            break;
+        case ARenderCommandList::Type::DrawMesh:
+            if (view) {
+                const ARenderCommandList::Mesh& mesh = commands.getMesh(command.index);
+                drawMesh(commands, mesh, mesh.model, mesh.color, *view, viewProjection);
+            }
+            break;
+        case ARenderCommandList::Type::DrawInstances:
+            if (view) {
+                const ARenderCommandList::Mesh& mesh = commands.getMesh(command.index);
+                const AInstance* instances = commands.getInstances().data() + mesh.firstInstance;
+                for (uint32_t i = 0; i < mesh.instanceCount; ++i) {
+                    drawMesh(commands, mesh, instances[i].transform, instances[i].color, *view, viewProjection);
+                }
+            }
+            break;
+        case ARenderCommandList::Type::DrawSprites:
+            if (view) {
+                drawSprites(commands, commands.getSpriteBatch(command.index), *view, viewProjection);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void SoftwareRasterizer::drawSprites(const ARenderCommandList& commands,
+                                     const ARenderCommandList::SpriteBatch& batch,
+                                     const ARenderCommandList::View& view,
+                                     const glm::mat4& viewProjection) {
+    const int minX = std::max(view.x, 0);
+    const int minY = std::max(view.y, 0);
+    const int maxX = std::min(view.x + view.width, width_) - 1;
+    const int maxY = std::min(view.y + view.height, height_) - 1;
+    if (maxX < minX || maxY < minY) {
+        return;
+    }
+    // Pixels per world unit at clip w = 1; dividing by w gives the size at the sprite's distance.
+    const float pixelScale = 0.5f * static_cast<float>(view.height) * std::abs(view.projection[1][1]);
+
+    const ARenderCommandList::Sprite* sprites = commands.getSprites().data() + batch.firstSprite;
+    for (uint32_t i = 0; i < batch.spriteCount; ++i) {
+        const ARenderCommandList::Sprite& sprite = sprites[i];
+        const glm::vec4 clip = viewProjection * glm::vec4(sprite.position, 1.0f);
+        if (clip.w <= 0.0f || clip.z < -clip.w || clip.z > clip.w) {
+            continue;
+        }
+        const float invW = 1.0f / clip.w;
+        const float centerX = static_cast<float>(view.x) + (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(view.width);
+        const float centerY = static_cast<float>(view.y) + (0.5f - clip.y * invW * 0.5f) * static_cast<float>(view.height);
+        // Never smaller than one pixel, so distant particles do not vanish.
+        const float half = std::max(0.5f * sprite.size * pixelScale * invW, 0.5f);
+        const int x0 = std::max(minX, static_cast<int>(std::ceil(centerX - half - 0.5f)));
+        const int x1 = std::min(maxX, static_cast<int>(std::floor(centerX + half - 0.5f)));
+        const int y0 = std::max(minY, static_cast<int>(std::ceil(centerY - half - 0.5f)));
+        const int y1 = std::min(maxY, static_cast<int>(std::floor(centerY + half - 0.5f)));
+        if (x0 > x1 || y0 > y1) {
+            continue;
+        }
+
+        const float depth = clip.z * invW * 0.5f + 0.5f;
+        const uint8_t b = static_cast<uint8_t>(std::clamp(sprite.color.b, 0.0f, 1.0f) * 255.0f);
+        const uint8_t g = static_cast<uint8_t>(std::clamp(sprite.color.g, 0.0f, 1.0f) * 255.0f);
+        const uint8_t r = static_cast<uint8_t>(std::clamp(sprite.color.r, 0.0f, 1.0f) * 255.0f);
+        for (int y = y0; y <= y1; ++y) {
+            float* depthRow = depthBuffer_.data() + static_cast<size_t>(y) * static_cast<size_t>(width_);
+            uint8_t* colorRow = colorBits_ + static_cast<size_t>(y) * static_cast<size_t>(colorStride_);
+            for (int x = x0; x <= x1; ++x) {
+                if (depth < depthRow[x]) {
+                    depthRow[x] = depth;
+                    uint8_t* pxPtr = colorRow + static_cast<size_t>(x) * 4;
+                    pxPtr[0] = b;
+                    pxPtr[1] = g;
+                    pxPtr[2] = r;
+                    pxPtr[3] = 255;
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::drawMesh(const ARenderCommandList& commands,
+                                  const ARenderCommandList::Mesh& mesh,
+                                  const glm::mat4& model,
+                                  const AEntity::Color& color,
+                                  const ARenderCommandList::View& view,
+                                  const glm::mat4& viewProjection) {
+    if (mesh.indexCount < 3) {
+        return;
+    }
+
+    const glm::mat4 mvp = viewProjection * model;
+    const glm::vec3* vertices = commands.getVertices().data() + mesh.firstVertex;
+    const AEntity::Color* vertexColors = commands.getVertexColors().data() + mesh.firstVertex;
+    const uint32_t* indices = commands.getIndices().data() + mesh.firstIndex;
+
+    auto toScreen = [&view](const ClipVertex& cv) {
+        const glm::vec3 ndc = glm::vec3(cv.pos) / cv.pos.w;
+        ScreenVertex sv;
+        sv.pos.x = static_cast<float>(view.x) + (ndc.x * 0.5f + 0.5f) * static_cast<float>(view.width);
+        sv.pos.y = static_cast<float>(view.y) + (1.0f - (ndc.y * 0.5f + 0.5f)) * static_cast<float>(view.height);
+        sv.depth01 = ndc.z * 0.5f + 0.5f;
+        sv.color = cv.color;
+        return sv;
+    };
+
+    // Post-transform cache indexed by vertex id: each vertex is transformed, classified and
+    // projected once per draw, then shared by every triangle that references it.
+    clipCache_.resize(mesh.vertexCount);
+    screenCache_.resize(mesh.vertexCount);
+    outcodes_.resize(mesh.vertexCount);
+    for (uint32_t i = 0; i < mesh.vertexCount; ++i) {
+        ClipVertex& cv = clipCache_[i];
+        cv.pos = mvp * glm::vec4(vertices[i], 1.0f);
+        cv.color = vertexColors[i];
+        outcodes_[i] = computeOutcode(cv.pos);
+        if (outcodes_[i] == 0) {
+            screenCache_[i] = toScreen(cv);
+        }
+    }
+
+    static constexpr std::array<ClipPlane, 6> planes = {
+        ClipPlane::Left, ClipPlane::Right,
+        ClipPlane::Bottom, ClipPlane::Top,
+        ClipPlane::Near, ClipPlane::Far
+    };
+    for (uint32_t t = 0; t + 2 < mesh.indexCount; t += 3) {
+        const uint32_t i0 = indices[t];
+        const uint32_t i1 = indices[t + 1];
+        const uint32_t i2 = indices[t + 2];
+        const uint8_t c0 = outcodes_[i0];
+        const uint8_t c1 = outcodes_[i1];
+        const uint8_t c2 = outcodes_[i2];
+        if ((c0 & c1 & c2) != 0) {
+            continue; // Entirely outside one plane.
+        }
+        if ((c0 | c1 | c2) == 0) {
+            rasterizeTriangle(screenCache_[i0], screenCache_[i1], screenCache_[i2], mesh.hasVertexColors, color, view);
+            continue;
+        }
+
+        // Only triangles crossing the frustum boundary pay for clipping, ping-ponging between two
+        // stack buffers so no plane allocates.
+        std::array<ClipVertex, kMaxClipVertices> polygons[2];
+        polygons[0][0] = clipCache_[i0];
+        polygons[0][1] = clipCache_[i1];
+        polygons[0][2] = clipCache_[i2];
+        size_t polygonSize = 3;
+        size_t current = 0;
+        for (ClipPlane plane : planes) {
+            polygonSize = clipPolygon(polygons[current].data(), polygonSize, plane, polygons[current ^ 1].data());
+            current ^= 1;
+            if (polygonSize < 3) {
+                break;
+            }
+        }
+        if (polygonSize < 3) {
+            continue;
+        }
+        clippedScratch_.clear();
+        for (size_t i = 0; i < polygonSize; ++i) {
+            clippedScratch_.push_back(toScreen(polygons[current][i]));
+        }
+        // Clipped polygons stay convex, so a fan covers them.
+        for (size_t i = 1; i + 1 < clippedScratch_.size(); ++i) {
+            rasterizeTriangle(clippedScratch_[0], clippedScratch_[i], clippedScratch_[i + 1], mesh.hasVertexColors, color, view);
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeTriangle(const ScreenVertex& v0,
+                                           const ScreenVertex& v1,
+                                           const ScreenVertex& v2,
+                                           bool interpolateColor,
+                                           const AEntity::Color& uniformColor,
+                                           const ARenderCommandList::View& view) {
+    // Bounding box (inclusive) clamped to the view rectangle inside the target.
+    const float minClipX = static_cast<float>(std::max(view.x, 0));
+    const float minClipY = static_cast<float>(std::max(view.y, 0));
+    const float maxClipX = static_cast<float>(std::min(view.x + view.width, width_) - 1);
+    const float maxClipY = static_cast<float>(std::min(view.y + view.height, height_) - 1);
+    if (maxClipX < minClipX || maxClipY < minClipY) {
+        return;
+    }
+
+    const float minXf = std::floor(std::min({v0.pos.x, v1.pos.x, v2.pos.x}));
+    const float maxXf = std::ceil(std::max({v0.pos.x, v1.pos.x, v2.pos.x}));
+    const float minYf = std::floor(std::min({v0.pos.y, v1.pos.y, v2.pos.y}));
+    const float maxYf = std::ceil(std::max({v0.pos.y, v1.pos.y, v2.pos.y}));
+
+    const int minX = static_cast<int>(std::clamp(minXf, minClipX, maxClipX));
+    const int maxX = static_cast<int>(std::clamp(maxXf, minClipX, maxClipX));
+    const int minY = static_cast<int>(std::clamp(minYf, minClipY, maxClipY));
+    const int maxY = static_cast<int>(std::clamp(maxYf, minClipY, maxClipY));
+
+    const glm::vec2 p0 = v0.pos;
+    const glm::vec2 p1 = v1.pos;
+    const glm::vec2 p2 = v2.pos;
+
+    auto edge = [](const glm::vec2& a, const glm::vec2& b, float px, float py) {
+        return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+    };
+
+    const float area = edge(p0, p1, p2.x, p2.y);
+    if (std::abs(area) < 1e-5f) {
+        return; // Degenerate.
+    }
+    const float invArea = 1.0f / area;
+
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            const float px = static_cast<float>(x) + 0.5f;
+            const float py = static_cast<float>(y) + 0.5f;
+
+            float w0 = edge(p1, p2, px, py);
+            float w1 = edge(p2, p0, px, py);
+            float w2 = edge(p0, p1, px, py);
+
+            // Accept if all have the same sign as area (top-left rule).
+            if ((w0 >= 0 && w1 >= 0 && w2 >= 0 && area > 0) || (w0 <= 0 && w1 <= 0 && w2 <= 0 && area < 0)) {
+                w0 *= invArea;
+                w1 *= invArea;
+                w2 *= invArea;
+                const float depth = v0.depth01 * w0 + v1.depth01 * w1 + v2.depth01 * w2;
+
+                const size_t idx = static_cast<size_t>(y) * static_cast<size_t>(width_) + static_cast<size_t>(x);
+                if (depth < depthBuffer_[idx]) {
+                    depthBuffer_[idx] = depth;
+
+                    AEntity::Color c = uniformColor;
+                    if (interpolateColor) {
+                        c.r = v0.color.r * w0 + v1.color.r * w1 + v2.color.r * w2;
+                        c.g = v0.color.g * w0 + v1.color.g * w1 + v2.color.g * w2;
+                        c.b = v0.color.b * w0 + v1.color.b * w1 + v2.color.b * w2;
+                        c.a = v0.color.a * w0 + v1.color.a * w1 + v2.color.a * w2;
+                    }
+
+                    uint8_t* pxPtr = colorBits_ + static_cast<size_t>(y) * static_cast<size_t>(colorStride_) + static_cast<size_t>(x) * 4;
+                    pxPtr[0] = static_cast<uint8_t>(std::clamp(c.b, 0.0f, 1.0f) * 255.0f);
+                    pxPtr[1] = static_cast<uint8_t>(std::clamp(c.g, 0.0f, 1.0f) * 255.0f);
+                    pxPtr[2] = static_cast<uint8_t>(std::clamp(c.r, 0.0f, 1.0f) * 255.0f);
+                    pxPtr[3] = 255;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ARenderCommandList>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// CPU triangle rasterizer with a depth buffer, shared by the backends that do not drive their
+// native API yet. Renders the mesh commands of a command list into a caller-owned BGRA surface;
+// text commands are left to the caller.
+class SoftwareRasterizer {
+public:
+    void setTarget(uint8_t* colorBits, int colorStride, int width, int height);
+    void releaseTarget();
+    bool hasTarget() const;
+
+    // Fast clear to opaque black (shared default across software backends) and far depth.
+    void clear();
+    void draw(const ARenderCommandList& commands);
+
+private:
+    struct ScreenVertex {
+        glm::vec2 pos{};
+        float depth01{1.0f};
+        AEntity::Color color{};
+    };
+
+    struct ClipVertex {
+        glm::vec4 pos{};
+        AEntity::Color color{};
+    };
+
+    // model and color come from the mesh payload, or from one instance of an instanced draw.
+    void drawMesh(const ARenderCommandList& commands,
+                  const ARenderCommandList::Mesh& mesh,
+                  const glm::mat4& model,
+                  const AEntity::Color& color,
+                  const ARenderCommandList::View& view,
+                  const glm::mat4& viewProjection);
+    // Screen-aligned squares at their center's depth: one projection per sprite, no triangle setup.
+    void drawSprites(const ARenderCommandList& commands,
+                     const ARenderCommandList::SpriteBatch& batch,
+                     const ARenderCommandList::View& view,
+                     const glm::mat4& viewProjection);
+    void rasterizeTriangle(const ScreenVertex& v0,
+                           const ScreenVertex& v1,
+                           const ScreenVertex& v2,
+                           bool interpolateColor,
+                           const AEntity::Color& uniformColor,
+                           const ARenderCommandList::View& view);
+
+    uint8_t* colorBits_{nullptr};
+    int colorStride_{0};
+    int width_{0};
+    int height_{0};
+    std::vector<float> depthBuffer_;
+    // Per-draw scratch reused across meshes and frames.
+    std::vector<ClipVertex> clipCache_;
+    std::vector<ScreenVertex> screenCache_;
+    std::vector<uint8_t> outcodes_;
+    std::vector<ScreenVertex> clippedScratch_;
+};
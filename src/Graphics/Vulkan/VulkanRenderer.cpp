@@ -1,17 +1,7 @@
 #include "VulkanRenderer.h"
 
 #include <AEntity>
-#include <AWorld>
-#include <AViewport>
-#include <ARenderOverlay>
-#include <AText>
-#include <AFloatingText>
-#include <glm/gtc/matrix_transform.hpp>
 #include <algorithm>
-#include <array>
-#include <cmath>
-#include <cstring>
-#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -25,83 +15,6 @@ COLORREF toColorRef(const AEntity::Color& c) {
         static_cast<BYTE>(std::clamp(c.b, 0.0f, 1.0f) * 255.0f));
 }
 
-bool projectToScreen(const glm::vec3& world, const glm::mat4& view, const glm::mat4& projection, int width, int height, POINT& out) {
-    glm::vec4 clip = projection * view * glm::vec4(world, 1.0f);
-    if (clip.w <= 0.0f) {
-        return false;
-    }
-    glm::vec3 ndc = glm::vec3(clip) / clip.w;
-    if (ndc.z < -1.0f || ndc.z > 1.0f) {
-        return false;
-    }
-    out.x = static_cast<int>((ndc.x * 0.5f + 0.5f) * static_cast<float>(width));
-    out.y = static_cast<int>((1.0f - (ndc.y * 0.5f + 0.5f)) * static_cast<float>(height));
-    return true;
-}
-
-struct ResolvedText {
-    std::string text;
-    int x{0};
-    int y{0};
-    bool alignRight{false};
-    int pixelHeight{16};
-    AEntity::Color color{};
-};
-
-std::vector<ResolvedText> collectTexts(const AViewport& viewport) {
-    std::vector<ResolvedText> out;
-
-    auto appendScreenText = [&](const AText& text) {
-        out.push_back(ResolvedText{
-            text.getText(),
-            text.getPosition().x,
-            text.getPosition().y,
-            text.isAlignRight(),
-            text.getPixelHeight(),
-            text.getColor()
-        });
-    };
-
-    auto appendFloatingText = [&](const AFloatingText& text) {
-        POINT screen{};
-        if (!projectToScreen(text.getWorldPosition(), viewport.getViewMatrix(), viewport.getProjectionMatrix(), viewport.getWidth(), viewport.getHeight(), screen)) {
-            return;
-        }
-        out.push_back(ResolvedText{
-            text.getText(),
-            screen.x,
-            screen.y,
-            false,
-            text.getPixelHeight(),
-            text.getColor()
-        });
-    };
-
-    for (const auto* overlay : viewport.getOverlays()) {
-        if (!overlay) {
-            continue;
-        }
-        for (const auto& text : overlay->getTexts()) {
-            if (text) {
-                appendScreenText(*text);
-            }
-        }
-        for (const auto& floating : overlay->getFloatingTexts()) {
-            if (floating) {
-                appendFloatingText(*floating);
-            }
-        }
-    }
-
-    if (auto* world = viewport.getWorld()) {
-        for (const auto& floating : world->getFloatingTexts()) {
-            appendFloatingText(*floating);
-        }
-    }
-
-    return out;
-}
-
 HFONT getOrCreateFont(int size, std::vector<VulkanRenderer::FontEntry>& cache) {
     for (auto& entry : cache) {
         if (entry.size == size && entry.font) {
@@ -118,18 +31,24 @@ HFONT getOrCreateFont(int size, std::vector<VulkanRenderer::FontEntry>& cache) {
     return font;
 }
 
-void drawOverlayText(HDC dc, const AViewport& viewport, std::vector<VulkanRenderer::FontEntry>& fontCache) {
+void drawOverlayText(HDC dc, const ARenderCommandList& commands, std::vector<VulkanRenderer::FontEntry>& fontCache) {
     if (!dc) {
         return;
     }
-    const auto resolved = collectTexts(viewport);
-    if (resolved.empty()) {
-        return;
-    }
 
     SetBkMode(dc, TRANSPARENT);
 
-    for (const auto& overlay : resolved) {
+    const ARenderCommandList::View* view = nullptr;
+    for (const auto& command : commands.getCommands()) {
+        if (command.type == ARenderCommandList::Type::SetView) {
+            view = &commands.getView(command.index);
+            continue;
+        }
+        if (command.type != ARenderCommandList::Type::DrawText || !view) {
+            continue;
+        }
+
+        const auto& overlay = commands.getText(command.index);
         HFONT font = getOrCreateFont(overlay.pixelHeight, fontCache);
         HFONT oldFont = nullptr;
         if (font) {
@@ -140,8 +59,8 @@ void drawOverlayText(HDC dc, const AViewport& viewport, std::vector<VulkanRender
 
         SIZE extent{};
         GetTextExtentPoint32A(dc, overlay.text.c_str(), static_cast<int>(overlay.text.size()), &extent);
-        int x = overlay.alignRight ? (viewport.getWidth() - overlay.x - extent.cx) : overlay.x;
-        TextOutA(dc, x, overlay.y, overlay.text.c_str(), static_cast<int>(overlay.text.size()));
+        int x = overlay.alignRight ? (view->width - overlay.x - extent.cx) : overlay.x;
+        TextOutA(dc, view->x + x, view->y + overlay.y, overlay.text.c_str(), static_cast<int>(overlay.text.size()));
 
         if (font && oldFont) {
             SelectObject(dc, oldFont);
@@ -161,6 +80,9 @@ bool VulkanRenderer::initialize(void* nativeWindow, int width, int height) {
     hwnd_ = static_cast<HWND>(nativeWindow);
     width_ = width;
     height_ = height;
+    if (!hwnd_) {
+        return false;
+    }
     ensureBackBuffer(width_, height_);
 
     // Minimal instance creation to validate that Vulkan runtime is reachable.
@@ -209,12 +131,7 @@ void VulkanRenderer::resize(int width, int height) {
     ensureBackBuffer(width_, height_);
 }
 
-void VulkanRenderer::setWorld(AWorld* world) {
-    // World data is consumed during GDI fallback draw; store the pointer.
-    world_ = world;
-}
-
-void VulkanRenderer::draw(const AViewport& viewport) {
+void VulkanRenderer::draw(const ARenderCommandList& commands) {
     // Placeholder: until a full Vulkan pipeline is added, render using a software rasterizer
     // backed by a depth buffer for correct visibility. This keeps the Vulkan backend visibly
     // working (non-black window) while honoring camera matrices.
@@ -222,177 +139,21 @@ void VulkanRenderer::draw(const AViewport& viewport) {
         return;
     }
 
-    HDC hdc = GetDC(hwnd_);
-
-    // Keep back buffer in sync with the viewport/window size.
-    if (viewport.getWidth() != backBufferWidth_ || viewport.getHeight() != backBufferHeight_) {
-        resize(viewport.getWidth(), viewport.getHeight());
-    }
-
-    // Bail early on minimized (zero-size) windows to avoid allocations and math issues.
-    if (viewport.getWidth() <= 0 || viewport.getHeight() <= 0) {
-        ReleaseDC(hwnd_, hdc);
-        return;
-    }
-
-    if (!backBufferDC_ || !backBufferBitmap_) {
-        ReleaseDC(hwnd_, hdc);
-        return;
-    }
-
-    // Clear color and depth buffers.
-    if (!colorBits_ || depthBuffer_.empty()) {
-        ReleaseDC(hwnd_, hdc);
-        return;
-    }
-    // Fast clear to opaque black (shared default across software backends).
-    std::memset(colorBits_, 0, static_cast<size_t>(colorStride_) * static_cast<size_t>(backBufferHeight_));
-    std::fill(depthBuffer_.begin(), depthBuffer_.end(), 1.0f);
-
-    if (!world_) {
-        BitBlt(hdc, 0, 0, backBufferWidth_, backBufferHeight_, backBufferDC_, 0, 0, SRCCOPY);
-        ReleaseDC(hwnd_, hdc);
+    // Bail early on minimized (zero-size) windows or a missing back buffer.
+    if (!backBufferDC_ || !backBufferBitmap_ || !rasterizer_.hasTarget()) {
         return;
     }
 
-    // Acquire the latest viewport matrices (already updated by the caller).
-    const glm::mat4 view = viewport.getViewMatrix();
-    const glm::mat4 projection = viewport.getProjectionMatrix();
-
-    struct ScreenVertex {
-        glm::vec2 pos{};
-        float depth01{1.0f};
-        AEntity::Color color{};
-    };
-
-    auto rasterizeTriangle = [&](const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, bool interpolateColor, const AEntity::Color& uniformColor) {
-        // Bounding box (inclusive) clamped to target.
-        const float minXf = std::floor(std::min({v0.pos.x, v1.pos.x, v2.pos.x}));
-        const float maxXf = std::ceil(std::max({v0.pos.x, v1.pos.x, v2.pos.x}));
-        const float minYf = std::floor(std::min({v0.pos.y, v1.pos.y, v2.pos.y}));
-        const float maxYf = std::ceil(std::max({v0.pos.y, v1.pos.y, v2.pos.y}));
-
-        const int minX = static_cast<int>(std::clamp(minXf, 0.0f, static_cast<float>(backBufferWidth_ - 1)));
-        const int maxX = static_cast<int>(std::clamp(maxXf, 0.0f, static_cast<float>(backBufferWidth_ - 1)));
-        const int minY = static_cast<int>(std::clamp(minYf, 0.0f, static_cast<float>(backBufferHeight_ - 1)));
-        const int maxY = static_cast<int>(std::clamp(maxYf, 0.0f, static_cast<float>(backBufferHeight_ - 1)));
-
-        const glm::vec2 p0 = v0.pos;
-        const glm::vec2 p1 = v1.pos;
-        const glm::vec2 p2 = v2.pos;
-
-        auto edge = [](const glm::vec2& a, const glm::vec2& b, float px, float py) {
-            return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
-        };
-
-        const float area = edge(p0, p1, p2.x, p2.y);
-        if (std::abs(area) < 1e-5f) {
-            return; // Degenerate.
-        }
-        const float invArea = 1.0f / area;
-
-        for (int y = minY; y <= maxY; ++y) {
-            for (int x = minX; x <= maxX; ++x) {
-                const float px = static_cast<float>(x) + 0.5f;
-                const float py = static_cast<float>(y) + 0.5f;
-
-                float w0 = edge(p1, p2, px, py);
-                float w1 = edge(p2, p0, px, py);
-                float w2 = edge(p0, p1, px, py);
-
-                // Accept if all have the same sign as area (top-left rule).
-                if ((w0 >= 0 && w1 >= 0 && w2 >= 0 && area > 0) || (w0 <= 0 && w1 <= 0 && w2 <= 0 && area < 0)) {
-                    w0 *= invArea;
-                    w1 *= invArea;
-                    w2 *= invArea;
-                    const float depth = v0.depth01 * w0 + v1.depth01 * w1 + v2.depth01 * w2;
-
-                    const size_t idx = static_cast<size_t>(y) * static_cast<size_t>(backBufferWidth_) + static_cast<size_t>(x);
-                    if (depth < depthBuffer_[idx]) {
-                        depthBuffer_[idx] = depth;
-
-                        AEntity::Color c = uniformColor;
-                        if (interpolateColor) {
-                            c.r = v0.color.r * w0 + v1.color.r * w1 + v2.color.r * w2;
-                            c.g = v0.color.g * w0 + v1.color.g * w1 + v2.color.g * w2;
-                            c.b = v0.color.b * w0 + v1.color.b * w1 + v2.color.b * w2;
-                            c.a = v0.color.a * w0 + v1.color.a * w1 + v2.color.a * w2;
-                        }
-
-                        uint8_t* pxPtr = colorBits_ + static_cast<size_t>(y) * static_cast<size_t>(colorStride_) + static_cast<size_t>(x) * 4;
-                        pxPtr[0] = static_cast<uint8_t>(std::clamp(c.b, 0.0f, 1.0f) * 255.0f);
-                        pxPtr[1] = static_cast<uint8_t>(std::clamp(c.g, 0.0f, 1.0f) * 255.0f);
-                        pxPtr[2] = static_cast<uint8_t>(std::clamp(c.r, 0.0f, 1.0f) * 255.0f);
-                        pxPtr[3] = 255;
-                    }
-                }
-            }
-        }
-    };
-
-    for (const auto& entityPtr : world_->getEntities()) {
-        const auto& vertices = entityPtr->getVertices();
-        if (vertices.size() < 3) {
-            continue;
-        }
-
-        const glm::mat4 model = glm::translate(glm::mat4(1.0f), entityPtr->getPosition());
-        const glm::mat4 mvp = projection * view * model;
-
-        std::vector<ScreenVertex> transformed;
-        transformed.reserve(vertices.size());
-
-        const auto& vertexColors = entityPtr->getVertexColors();
-        const bool hasPerVertexColors = vertexColors.size() == vertices.size();
-        for (size_t i = 0; i < vertices.size(); ++i) {
-            glm::vec4 clip = mvp * glm::vec4(vertices[i], 1.0f);
-            if (clip.w <= 0.0f) {
-                transformed.clear();
-                break;
-            }
-            glm::vec3 ndc = glm::vec3(clip) / clip.w;
-            if (ndc.z < -1.0f || ndc.z > 1.0f) {
-                transformed.clear();
-                break;
-            }
-
-            ScreenVertex sv;
-            sv.pos.x = (ndc.x * 0.5f + 0.5f) * static_cast<float>(viewport.getWidth());
-            sv.pos.y = (1.0f - (ndc.y * 0.5f + 0.5f)) * static_cast<float>(viewport.getHeight());
-            sv.depth01 = ndc.z * 0.5f + 0.5f;
-            sv.color = hasPerVertexColors ? vertexColors[i] : entityPtr->getColor();
-            transformed.push_back(sv);
-        }
-
-        if (transformed.size() < 3) {
-            continue;
-        }
+    HDC hdc = GetDC(hwnd_);
 
-        const bool interpolateColor = hasPerVertexColors;
-        const AEntity::Color uniform = entityPtr->getColor();
-
-        // Triangle list: triangles if size==3, quad split into two, otherwise fan.
-        auto emitTriangle = [&](size_t i0, size_t i1, size_t i2) {
-            rasterizeTriangle(transformed[i0], transformed[i1], transformed[i2], interpolateColor, uniform);
-        };
-
-        if (transformed.size() == 3) {
-            emitTriangle(0, 1, 2);
-        } else if (transformed.size() == 4) {
-            emitTriangle(0, 1, 2);
-            emitTriangle(0, 2, 3);
-        } else {
-            for (size_t i = 1; i + 1 < transformed.size(); ++i) {
-                emitTriangle(0, i, i + 1);
-            }
-        }
-    }
+    rasterizer_.clear();
+    rasterizer_.draw(commands);
 
-    drawOverlayText(backBufferDC_, viewport, fontCache_);
+    drawOverlayText(backBufferDC_, commands, fontCache_);
 
     // Blit the finished back buffer to the window DC in one go to avoid flicker.
     BitBlt(hdc, 0, 0, backBufferWidth_, backBufferHeight_, backBufferDC_, 0, 0, SRCCOPY);
-    drawOverlayText(hdc, viewport, fontCache_);
+    drawOverlayText(hdc, commands, fontCache_);
     ReleaseDC(hwnd_, hdc);
 }
 
@@ -429,7 +190,7 @@ void VulkanRenderer::ensureBackBuffer(int width, int height) {
         backBufferDC_ = nullptr;
         colorBits_ = nullptr;
         backBufferWidth_ = backBufferHeight_ = 0;
-        depthBuffer_.clear();
+        rasterizer_.releaseTarget();
         ReleaseDC(hwnd_, windowDC);
         return;
     }
@@ -438,7 +199,7 @@ void VulkanRenderer::ensureBackBuffer(int width, int height) {
 
     backBufferWidth_ = width;
     backBufferHeight_ = height;
-    depthBuffer_.assign(static_cast<size_t>(width) * static_cast<size_t>(height), 1.0f);
+    rasterizer_.setTarget(colorBits_, colorStride_, width, height);
 
     ReleaseDC(hwnd_, windowDC);
 }
@@ -460,5 +221,5 @@ void VulkanRenderer::releaseBackBuffer() {
     colorStride_ = 0;
     backBufferWidth_ = 0;
     backBufferHeight_ = 0;
-    depthBuffer_.clear();
+    rasterizer_.releaseTarget();
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Graphics/IRendererImpl.h>
+#include <Graphics/Software/SoftwareRasterizer.h>
 #ifndef NOMINMAX
 #define NOMINMAX
 #endif
@@ -18,8 +19,7 @@ public:
     bool initialize(void* nativeWindow, int width, int height) override;
     void shutdown() override;
     void resize(int width, int height) override;
-    void draw(const AViewport& viewport) override;
-    void setWorld(class AWorld* world) override;
+    void draw(const ARenderCommandList& commands) override;
 
     struct FontEntry {
         int size{0};
@@ -27,7 +27,6 @@ public:
     };
 
 private:
-    AWorld* world_{nullptr};
     HWND hwnd_{nullptr};
     int width_{0};
     int height_{0};
@@ -41,7 +40,7 @@ private:
     int colorStride_{0};
     int backBufferWidth_{0};
     int backBufferHeight_{0};
-    std::vector<float> depthBuffer_;
+    SoftwareRasterizer rasterizer_;
     std::vector<FontEntry> fontCache_;
 
     void ensureBackBuffer(int width, int height);
@@ -2,6 +2,7 @@
 
 #include <AEvent>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -13,7 +14,8 @@ public:
     virtual void close() = 0;
     virtual bool isOpen() const = 0;
 
-    virtual std::vector<std::shared_ptr<AEvent>> pollEvents() = 0;
+    // Allocates the list and its events from AFrameArena::current().
+    virtual std::pmr::vector<AEvent> pollEvents() = 0;
 
     virtual void* getNativeHandle() const = 0;
     virtual int getWidth() const = 0;
@@ -0,0 +1,64 @@
+#include "AWindowImplOffscreen.h"
+
+#include <AFrameArena>
+
+AWindowImplOffscreen::AWindowImplOffscreen() = default;
+
+AWindowImplOffscreen::~AWindowImplOffscreen() {
+    close();
+}
+
+bool AWindowImplOffscreen::create(const std::string& title, int width, int height, void* parentHandle, int x, int y, bool child) {
+    (void)parentHandle;
+    (void)x;
+    (void)y;
+    (void)child;
+    title_ = title;
+    width_ = width;
+    height_ = height;
+    open_ = true;
+    return true;
+}
+
+void AWindowImplOffscreen::close() {
+    open_ = false;
+}
+
+bool AWindowImplOffscreen::isOpen() const {
+    return open_;
+}
+
+std::pmr::vector<AEvent> AWindowImplOffscreen::pollEvents() {
+    return std::pmr::vector<AEvent>(&AFrameArena::current());
+}
+
+void* AWindowImplOffscreen::getNativeHandle() const {
+    return nullptr;
+}
+
+int AWindowImplOffscreen::getWidth() const {
+    return width_;
+}
+
+int AWindowImplOffscreen::getHeight() const {
+    return height_;
+}
+
+void AWindowImplOffscreen::setTitle(const std::string& title) {
+    title_ = title;
+}
+
+void AWindowImplOffscreen::setRect(int x, int y, int width, int height) {
+    (void)x;
+    (void)y;
+    width_ = width;
+    height_ = height;
+}
+
+void AWindowImplOffscreen::setCursorGrabbed(bool grabbed) {
+    cursorGrabbed_ = grabbed;
+}
+
+bool AWindowImplOffscreen::isCursorGrabbed() const {
+    return cursorGrabbed_;
+}
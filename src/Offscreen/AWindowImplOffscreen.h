@@ -0,0 +1,35 @@
+#pragma once
+
+#include <IWindowImpl.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Window implementation without a window system: it only tracks its size and open state, so the
+// AWindow/AViewport/AWorld stack can run on servers with no display. It never produces events.
+class AWindowImplOffscreen : public IWindowImpl {
+public:
+    AWindowImplOffscreen();
+    ~AWindowImplOffscreen() override;
+
+    bool create(const std::string& title, int width, int height, void* parentHandle, int x, int y, bool child) override;
+    void close() override;
+    bool isOpen() const override;
+
+    std::pmr::vector<AEvent> pollEvents() override;
+
+    void* getNativeHandle() const override;
+    int getWidth() const override;
+    int getHeight() const override;
+    void setTitle(const std::string& title) override;
+    void setRect(int x, int y, int width, int height) override;
+    void setCursorGrabbed(bool grabbed) override;
+    bool isCursorGrabbed() const override;
+
+private:
+    std::string title_;
+    bool open_{false};
+    bool cursorGrabbed_{false};
+    int width_{0};
+    int height_{0};
+};
@@ -1,6 +1,7 @@
 #include "AWindowImplWin32.h"
 
 #include <AEvent>
+#include <AFrameArena>
 #include <EEventKey>
 #include <cassert>
 #include <windowsx.h>
@@ -118,8 +119,9 @@ bool AWindowImplWin32::isOpen() const {
     return open_;
 }
 
-std::vector<std::shared_ptr<AEvent>> AWindowImplWin32::pollEvents() {
-    events_.clear();
+std::pmr::vector<AEvent> AWindowImplWin32::pollEvents() {
+    std::pmr::vector<AEvent> collected(&AFrameArena::current());
+    events_ = &collected;
 
     MSG msg{};
     while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
@@ -127,8 +129,7 @@ std::vector<std::shared_ptr<AEvent>> AWindowImplWin32::pollEvents() {
         DispatchMessage(&msg);
     }
 
-    std::vector<std::shared_ptr<AEvent>> collected;
-    collected.swap(events_);
+    events_ = nullptr;
     return collected;
 }
 
@@ -205,7 +206,7 @@ LRESULT CALLBACK AWindowImplWin32::WndProc(HWND hwnd, UINT msg, WPARAM wParam, L
     switch (msg) {
     case WM_CLOSE: {
         self->open_ = false;
-        self->pushEvent(std::make_shared<AEvent::Closed>());
+        self->pushEvent(AEvent::Closed{});
         DestroyWindow(hwnd);
         return 0;
     }
@@ -221,14 +222,14 @@ LRESULT CALLBACK AWindowImplWin32::WndProc(HWND hwnd, UINT msg, WPARAM wParam, L
     case WM_KEYDOWN: {
         auto scancode = mapVirtualKey(wParam);
         if (scancode != EEventKey::Scancode::Unknown) {
-            self->pushEvent(std::make_shared<AEvent::KeyPressed>(scancode));
+            self->pushEvent(AEvent::KeyPressed(scancode));
         }
         break;
     }
     case WM_KEYUP: {
         auto scancode = mapVirtualKey(wParam);
         if (scancode != EEventKey::Scancode::Unknown) {
-            self->pushEvent(std::make_shared<AEvent::KeyReleased>(scancode));
+            self->pushEvent(AEvent::KeyReleased(scancode));
         }
         break;
     }
@@ -237,7 +238,7 @@ LRESULT CALLBACK AWindowImplWin32::WndProc(HWND hwnd, UINT msg, WPARAM wParam, L
         const float y = static_cast<float>(GET_Y_LPARAM(lParam));
         glm::vec2 delta{x - self->lastMouse_.x, y - self->lastMouse_.y};
         self->lastMouse_ = {x, y};
-        self->pushEvent(std::make_shared<AEvent::MouseMoved>(delta.x, delta.y, x, y));
+        self->pushEvent(AEvent::MouseMoved(delta.x, delta.y, x, y));
         if (self->cursorGrabbed_) {
             self->centerCursor();
         }
@@ -250,7 +251,7 @@ LRESULT CALLBACK AWindowImplWin32::WndProc(HWND hwnd, UINT msg, WPARAM wParam, L
     case WM_RBUTTONDOWN:
     case WM_MBUTTONDOWN: {
         auto scancode = mapMouseButton(msg);
-        self->pushEvent(std::make_shared<AEvent::MouseButtonPressed>(scancode));
+        self->pushEvent(AEvent::MouseButtonPressed(scancode));
         if (self->cursorGrabbed_) {
             self->centerCursor();
         }
@@ -260,7 +261,7 @@ LRESULT CALLBACK AWindowImplWin32::WndProc(HWND hwnd, UINT msg, WPARAM wParam, L
     case WM_RBUTTONUP:
     case WM_MBUTTONUP: {
         auto scancode = mapMouseButton(msg);
-        self->pushEvent(std::make_shared<AEvent::MouseButtonReleased>(scancode));
+        self->pushEvent(AEvent::MouseButtonReleased(scancode));
         break;
     }
     default:
@@ -270,8 +271,11 @@ LRESULT CALLBACK AWindowImplWin32::WndProc(HWND hwnd, UINT msg, WPARAM wParam, L
     return DefWindowProc(hwnd, msg, wParam, lParam);
 }
 
-void AWindowImplWin32::pushEvent(const std::shared_ptr<AEvent>& event) {
-    events_.push_back(event);
+void AWindowImplWin32::pushEvent(const AEvent& event) {
+    // Messages sent outside pollEvents() (e.g. by SetWindowPos) have no list to go to.
+    if (events_) {
+        events_->push_back(event);
+    }
 }
 
 void AWindowImplWin32::handleSizeChange(LPARAM lParam) {
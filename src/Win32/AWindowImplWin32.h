@@ -7,6 +7,7 @@
 #include <Windows.h>
 #include <glm/vec2.hpp>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -19,7 +20,7 @@ public:
     void close() override;
     bool isOpen() const override;
 
-    std::vector<std::shared_ptr<AEvent>> pollEvents() override;
+    std::pmr::vector<AEvent> pollEvents() override;
 
     void* getNativeHandle() const override;
     int getWidth() const override;
@@ -31,7 +32,7 @@ public:
 
 private:
     static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
-    void pushEvent(const std::shared_ptr<AEvent>& event);
+    void pushEvent(const AEvent& event);
     void handleSizeChange(LPARAM lParam);
     void centerCursor();
 
@@ -42,5 +43,5 @@ private:
     int width_{0};
     int height_{0};
     glm::vec2 lastMouse_{0.0f, 0.0f};
-    std::vector<std::shared_ptr<AEvent>> events_;
+    std::pmr::vector<AEvent>* events_{nullptr}; // Set while pollEvents() dispatches.
 };
@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include <AWindow>
+#include <AViewport>
+#include <AWorld>
+#include <AEntity>
+#include <AFreeCamera>
+#include <AEvent>
+#include <AText>
+#include <AFloatingText>
+#include <AParticleSystem>
+#include <ARenderOverlay>
+#include <AFramePipeline>
+#include <AAllocationCounter>
+
+// Runs the demo's frame loop on headless windows and fails if a frame allocates once warmed up.
+// Needs no window system, so it runs wherever the engine builds (ctest -R allocation_check).
+
+namespace {
+
+// Longer than the particles live, so the fountain and every buffer sized by it have peaked.
+constexpr int kWarmupFrames = 240;
+constexpr int kCheckedFrames = 120;
+constexpr float kDeltaTime = 1.0f / 60.0f;
+
+} // namespace
+
+int main()
+{
+    if (!AAllocationCounter::isEnabled()) {
+        std::fprintf(stderr, "Engine built without ENABLE_ALLOCATION_COUNTER; nothing to check\n");
+        return 1;
+    }
+
+    AWindow left("Allocation check", 320, 240, EGraphicsBackend::Headless);
+    AWindow right("Allocation check", 320, 240, EGraphicsBackend::Headless);
+
+    AWorld world;
+    left.getViewport().setWorld(world);
+    right.getViewport().setWorld(world);
+
+    AEntity triangle = world.createTriangle(glm::vec3(0, 0, 0), glm::vec3(5, 0, 0), glm::vec3(0, 0, 5));
+    triangle.setVertexColors({{1.0f, 0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f, 1.0f}, {0.0f, 0.0f, 1.0f, 1.0f}});
+    for (int i = 0; i < 64; ++i) {
+        AEntity tile = world.createRectangle(2, 1);
+        tile.setPosition({static_cast<float>(i % 8) * 3.0f - 12.0f, static_cast<float>(i / 8) * 2.0f - 8.0f, 0.0f});
+        tile.setColor({0.76f, 0.70f, 0.50f, 1.0f});
+    }
+    world.addFloatingText(AFloatingText("Hello world!", glm::vec3(1.5f, 1.5f, 1.5f), 18));
+
+    AFreeCamera camera(left.getViewport(), glm::vec3(0, 0, 30), glm::vec3(0, 0, 0));
+    camera.addViewport(right.getViewport());
+
+    ARenderOverlay hudOverlay;
+    AText& fpsText = hudOverlay.addText(AText("FPS: 0.0", {12, 12}, true, 16, {0.9f, 0.9f, 0.9f, 1.0f}));
+    AText& particleText = hudOverlay.addText(AText("", {12, 32}, false, 14, {0.7f, 0.9f, 1.0f, 1.0f}));
+    left.getViewport().addOverlay(hudOverlay);
+    right.getViewport().addOverlay(hudOverlay);
+
+    // Enough particles for update() to split across the worker pool where the machine has threads.
+    AParticleSystem& fountain = world.addParticleSystem(40000);
+    AParticleSystem::Emitter emitter;
+    emitter.velocity = glm::vec3(0.0f, 0.0f, 9.0f);
+    emitter.velocityJitter = glm::vec3(2.0f, 2.0f, 1.5f);
+    emitter.rate = 20000.0f;
+    emitter.minLifetime = 1.5f;
+    emitter.maxLifetime = 2.5f;
+    fountain.setEmitter(emitter);
+    fountain.setWorkerCount(2);
+
+    AFramePipeline framePipeline(2);
+    framePipeline.addWindow(left);
+    framePipeline.addWindow(right);
+
+    uint64_t countAfterWarmup = 0;
+    for (int frame = 0; frame < kWarmupFrames + kCheckedFrames; ++frame) {
+        if (frame == kWarmupFrames) {
+            countAfterWarmup = AAllocationCounter::getCount();
+        }
+
+        for (const AEvent& event : left.pollEvents()) {
+            camera.dispatchEvent(event);
+        }
+
+        char fpsBuffer[32];
+        std::snprintf(fpsBuffer, sizeof(fpsBuffer), "FPS: %.1f", 1.0f / kDeltaTime);
+        fpsText.setText(fpsBuffer);
+        char particleBuffer[96];
+        std::snprintf(particleBuffer, sizeof(particleBuffer), "Particles: %u (frame %d)", fountain.getCount(), frame);
+        particleText.setText(particleBuffer);
+
+        world.flushRemovals();
+        world.updateParticles(kDeltaTime);
+        world.updateTransforms();
+        world.commitChanges();
+        framePipeline.submit();
+    }
+    // Waits for the render thread, so its work on the checked frames is counted too.
+    framePipeline.flush();
+    const uint64_t allocations = AAllocationCounter::getCount() - countAfterWarmup;
+
+    if (countAfterWarmup == 0) {
+        // Setting up the scene allocates, so the counting operator new was not linked in.
+        std::fprintf(stderr, "No allocations counted during warm-up; the counter is not active\n");
+        return 1;
+    }
+    std::printf("%llu heap allocations in %d frames after warm-up\n", static_cast<unsigned long long>(allocations),
+                kCheckedFrames);
+    return allocations == 0 ? 0 : 1;
+}
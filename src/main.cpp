@@ -1,17 +1,23 @@
 #include <algorithm>
+#include <cstdint>
 #include <cstdio>
 #include <glm/glm.hpp>
 #include <AWindow>
 #include <AViewport>
 #include <AWorld>
+#include <ATerrain>
 #include <AEntity>
 #include <AFreeCamera>
 #include <AEvent>
 #include <AText>
 #include <AFloatingText>
+#include <AParticleSystem>
 #include <ARenderOverlay>
 #include <AFpsCounter>
 #include <ARenderTimeTracker>
+#include <AFramePipeline>
+#include <AFrameArena>
+#include <AAllocationCounter>
 #include <EEventKey>
 
 int main(int argc, char* argv[])
@@ -41,19 +47,31 @@ int main(int argc, char* argv[])
     viewportDX11.setWorld(world);
     viewportDX12.setWorld(world);
 
-    AEntity* e1 = AEntity::createTriangle(glm::vec3(0,0,0), glm::vec3(5, 0, 0), glm::vec3(0, 0, 5));
-    AEntity* e2 = AEntity::createRectangle(20, 10);
+    AEntity e1 = world.createTriangle(glm::vec3(0,0,0), glm::vec3(5, 0, 0), glm::vec3(0, 0, 5));
+    AEntity e2 = world.createRectangle(20, 10);
 
     // Color setup: triangle with primary vertex colors (RGB), rectangle with sand-like color.
-    e1->setVertexColors({
+    e1.setVertexColors({
         {1.0f, 0.0f, 0.0f, 1.0f}, // Red
         {0.0f, 1.0f, 0.0f, 1.0f}, // Green
         {0.0f, 0.0f, 1.0f, 1.0f}  // Blue
     });
-    e2->setColor({0.76f, 0.70f, 0.50f, 1.0f}); // Sand tone
+    e2.setColor({0.76f, 0.70f, 0.50f, 1.0f}); // Sand tone
 
-    world.addEntity(e1);
-    world.addEntity(e2);
+    // Optional scene file (see ASceneFile) added on top of the built-in entities.
+    if (argc > 1 && !world.loadScene(argv[1])) {
+        std::fprintf(stderr, "Could not load scene '%s'\n", argv[1]);
+    }
+
+    // Optional streamed terrain (see ATerrain).
+    ATerrain terrain;
+    if (argc > 2) {
+        if (terrain.open(argv[2])) {
+            world.setTerrain(&terrain);
+        } else {
+            std::fprintf(stderr, "Could not open terrain '%s'\n", argv[2]);
+        }
+    }
 
     // Controls
     AFreeCamera camera(viewportGL, glm::vec3(0, 0, 30), glm::vec3(0, 0, 0)); // Viewport, Position, Lookat
@@ -68,9 +86,14 @@ int main(int argc, char* argv[])
     ARenderOverlay hudOverlay;
     AText& fpsText = hudOverlay.addText(AText("FPS: 0.0", {12, 12}, true, 16, {0.9f, 0.9f, 0.9f, 1.0f}));
     AText& camDebugText = hudOverlay.addText(AText("", {12, 32}, false, 14, {0.7f, 0.9f, 1.0f, 1.0f}));
+    AText& particleText = hudOverlay.addText(AText("", {12, 52}, false, 14, {0.7f, 0.9f, 1.0f, 1.0f}));
+    AText& pickText = hudOverlay.addText(AText("", {12, 72}, false, 14, {1.0f, 0.9f, 0.6f, 1.0f}));
+    AText& heapText = hudOverlay.addText(AText("", {12, 92}, false, 14, {0.7f, 0.9f, 1.0f, 1.0f}));
+    uint64_t lastHeapAllocations = 0;
+    glm::vec2 mousePosition{0.0f};
     bool showCamDebug = true;
 
-    const auto& triVerts = e1->getVertices();
+    const auto triVerts = e1.getVertices();
     glm::vec3 triCentroid{0.0f};
     for (const auto& v : triVerts) {
         triCentroid += v;
@@ -79,8 +102,19 @@ int main(int argc, char* argv[])
         triCentroid /= static_cast<float>(triVerts.size());
     }
     const glm::vec3 triLabelPos = triCentroid + glm::vec3(0.0f, 1.5f, 0.0f);
-    AFloatingText* triangleLabel = new AFloatingText("Hello world!", triLabelPos, 18);
-    world.addFloatingText(triangleLabel);
+    world.addFloatingText(AFloatingText("Hello world!", triLabelPos, 18));
+
+    // Particle fountain rising from the origin toward the camera.
+    AParticleSystem& fountain = world.addParticleSystem(20000);
+    AParticleSystem::Emitter fountainEmitter;
+    fountainEmitter.positionJitter = glm::vec3(0.2f, 0.2f, 0.0f);
+    fountainEmitter.velocity = glm::vec3(0.0f, 0.0f, 9.0f);
+    fountainEmitter.velocityJitter = glm::vec3(2.0f, 2.0f, 1.5f);
+    fountainEmitter.rate = 8000.0f;
+    fountainEmitter.minLifetime = 1.5f;
+    fountainEmitter.maxLifetime = 2.5f;
+    fountain.setEmitter(fountainEmitter);
+    fountain.setWorkerCount(2);
 
     viewportGL.addOverlay(hudOverlay);
     viewportVK.addOverlay(hudOverlay);
@@ -89,6 +123,21 @@ int main(int argc, char* argv[])
 
     AFpsCounter fpsCounter;
 
+    // Keep every backend a window has used alive so cycling with 'O' does not rebuild renderers.
+    glRender.setRendererPoolEnabled(true);
+    vkRender.setRendererPoolEnabled(true);
+    dx11Render.setRendererPoolEnabled(true);
+    dx12Render.setRendererPoolEnabled(true);
+
+    // Render thread draws frame N while this loop builds frame N+1 (double-buffered packets).
+    ARenderTimeTracker renderTimeTracker;
+    AFramePipeline framePipeline(2);
+    framePipeline.setTimeTracker(&renderTimeTracker);
+    framePipeline.addWindow(glRender);
+    framePipeline.addWindow(vkRender);
+    framePipeline.addWindow(dx11Render);
+    framePipeline.addWindow(dx12Render);
+
     int lastLayoutWidth = -1;
     int lastLayoutHeight = -1;
     auto updateViewportLayout = [&]() -> bool {
@@ -115,18 +164,22 @@ int main(int argc, char* argv[])
     while (mainWindow.isOpen())
     {
         const float deltaTime = fpsCounter.tick();
+        // Everything allocated since the previous iteration, render thread included.
+        const uint64_t heapAllocationCount = AAllocationCounter::getCount();
+        const uint64_t frameHeapAllocations = heapAllocationCount - lastHeapAllocations;
+        lastHeapAllocations = heapAllocationCount;
 
         if (updateViewportLayout()) {
             camera.refreshMatrices();
         }
 
-        for (auto event : mainWindow.pollEvents())
+        for (const AEvent& event : mainWindow.pollEvents())
         {
-            if (event->is<AEvent::Closed>())
+            if (event.is<AEvent::Closed>())
             {
                 mainWindow.close();
             }
-            else if (const auto* keyPressed = event->getIf<AEvent::KeyPressed>())
+            else if (const auto* keyPressed = event.getIf<AEvent::KeyPressed>())
             {
                 if (keyPressed->scancode == EEventKey::Scancode::Escape)
                     mainWindow.close();
@@ -148,16 +201,48 @@ int main(int argc, char* argv[])
                         default: return EGraphicsBackend::OpenGL;
                         }
                     };
+                    // Renderers are about to be replaced; let the render thread finish with them first.
+                    framePipeline.flush();
                     glRender.setGraphicsBackend(nextBackend(glRender.getGraphicsBackend()));
                     vkRender.setGraphicsBackend(nextBackend(vkRender.getGraphicsBackend()));
                     dx11Render.setGraphicsBackend(nextBackend(dx11Render.getGraphicsBackend()));
                     dx12Render.setGraphicsBackend(nextBackend(dx12Render.getGraphicsBackend()));
+                    renderTimeTracker.recordSwitch(glRender);
+                    renderTimeTracker.recordSwitch(vkRender);
+                    renderTimeTracker.recordSwitch(dx11Render);
+                    renderTimeTracker.recordSwitch(dx12Render);
                 }
                 else if (keyPressed->scancode == EEventKey::Scancode::L)
                 {
                     showCamDebug = !showCamDebug;
                 }
             }
+            else if (const auto* mouseMoved = event.getIf<AEvent::MouseMoved>())
+            {
+                mousePosition = mouseMoved->position;
+            }
+            else if (const auto* mousePressed = event.getIf<AEvent::MouseButtonPressed>())
+            {
+                // With the cursor released, left click picks the entity under it in whichever quadrant it is over.
+                if (mousePressed->scancode == EEventKey::Scancode::MouseLeft && !cursorCaptured)
+                {
+                    const float halfW = static_cast<float>(std::max(1, lastLayoutWidth / 2));
+                    const float halfH = static_cast<float>(std::max(1, lastLayoutHeight / 2));
+                    const bool right = mousePosition.x >= halfW;
+                    const bool bottom = mousePosition.y >= halfH;
+                    AWindow& target = bottom ? (right ? dx12Render : dx11Render) : (right ? vkRender : glRender);
+                    const glm::vec2 local = mousePosition - glm::vec2(right ? halfW : 0.0f, bottom ? halfH : 0.0f);
+                    AWorld::RayHit hit;
+                    char pickBuffer[96];
+                    if (world.pick(target.getViewport(), local, hit)) {
+                        std::snprintf(pickBuffer, sizeof(pickBuffer), "Picked entity %u (triangle %u) at %.1f",
+                                      hit.index, hit.triangle, hit.distance);
+                    } else {
+                        std::snprintf(pickBuffer, sizeof(pickBuffer), "Picked nothing");
+                    }
+                    pickText.setText(pickBuffer);
+                }
+            }
 
             camera.dispatchEvent(event);
         }
@@ -173,15 +258,34 @@ int main(int argc, char* argv[])
                           "Cam pos(%.1f, %.1f, %.1f) fwd(%.2f, %.2f, %.2f)",
                           pos.x, pos.y, pos.z, fwd.x, fwd.y, fwd.z);
             camDebugText.setText(camBuffer);
+            char particleBuffer[96];
+            std::snprintf(particleBuffer, sizeof(particleBuffer), "Particles: %u (update %.2f ms)",
+                          fountain.getCount(), fountain.getStats().updateMilliseconds);
+            particleText.setText(particleBuffer);
+            char heapBuffer[96];
+            if (AAllocationCounter::isEnabled()) {
+                std::snprintf(heapBuffer, sizeof(heapBuffer), "Heap allocations/frame: %llu (frame arena %zu B)",
+                              static_cast<unsigned long long>(frameHeapAllocations), AFrameArena::current().getUsedBytes());
+            } else {
+                std::snprintf(heapBuffer, sizeof(heapBuffer), "Frame arena %zu B", AFrameArena::current().getUsedBytes());
+            }
+            heapText.setText(heapBuffer);
         } else {
             camDebugText.setText("");
+            particleText.setText("");
+            heapText.setText("");
         }
 
-        ARenderTimeTracker::trackDraw(glRender);
-        ARenderTimeTracker::trackDraw(vkRender);
-        ARenderTimeTracker::trackDraw(dx11Render);
-        ARenderTimeTracker::trackDraw(dx12Render);
+        // Apply this frame's despawns before the world is snapshotted into command lists.
+        world.flushRemovals();
+        world.updateParticles(deltaTime);
+        world.updateTransforms();
+        world.commitChanges();
+        terrain.update(camera.getPosition());
+        framePipeline.submit();
     }
 
+    framePipeline.flush();
+
     return 0;
 }